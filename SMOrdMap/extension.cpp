@@ -39,6 +39,7 @@ class OrdMapTypeHandler : public IHandleTypeDispatch {
 public:
 	void OnHandleDestroy(HandleType_t type, void *object) {
 		CMap *map = ( CMap* )object;
+		ForgetCachedMap(map);
 		map_free(&map);
 	}
 };
@@ -46,8 +47,10 @@ public:
 
 HandleType_t g_OrdMapType = 0;
 OrdMapTypeHandler g_OrdMapTypeHandler;
+MapKeyPool g_KeyPool;
 
 bool SMOrdMap::SDK_OnLoad(char *error, size_t maxlen, bool late) {
+	map_key_pool_init(&g_KeyPool);
 	g_OrdMapType = g_pHandleSys->CreateType("OrdMap", &g_OrdMapTypeHandler, 0, NULL, NULL, myself->GetIdentity(), NULL);
 	sharesys->AddNatives(myself, g_Natives);
 	sharesys->RegisterLibrary(myself, "OrdMap");
@@ -56,6 +59,8 @@ bool SMOrdMap::SDK_OnLoad(char *error, size_t maxlen, bool late) {
 
 void SMOrdMap::SDK_OnUnload() {
 	g_pHandleSys->RemoveType(g_OrdMapType, myself->GetIdentity());
+	/// removing the type destroyed every map, nothing references the interned keys anymore.
+	map_key_pool_clear(&g_KeyPool);
 }
 
 SMEXT_LINK(&g_OrdMap);
\ No newline at end of file
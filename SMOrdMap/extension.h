@@ -41,6 +41,7 @@
 class OrdMapTypeHandler;
 
 extern HandleType_t g_OrdMapType;
+extern MapKeyPool g_KeyPool; /// interned string keys shared by every `OrdMapInternKeys` map.
 
 class SMOrdMap : public SDKExtension {
 public:
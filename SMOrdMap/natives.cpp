@@ -9,6 +9,52 @@ static HandleSecurity MakeHandleSec() {
 	return sec;
 }
 
+/// the handle each plugin context resolved last, plugins tend to call many natives in a row on one map.
+/// slots are picked by context address, a collision just costs a regular `ReadHandle`.
+/// a handle value embeds its serial so a recycled handle never matches a stale slot,
+/// and `ForgetCachedMap` drops a map's slots before the map is freed.
+/// only the handle that created a map (kept in `CMap::user`) is cached. a `CloneHandle` alias is released
+/// without `OnHandleDestroy` running, so a cached alias would stay usable after it was closed.
+enum { HANDLE_CACHE_SIZE = 64 };
+struct HandleCacheSlot {
+	IPluginContext *ctx;
+	Handle_t        hndl;
+	CMap           *map;
+};
+static HandleCacheSlot g_HandleCache[HANDLE_CACHE_SIZE];
+
+static HandleCacheSlot *HandleCacheFor(IPluginContext *pContext) {
+	return &g_HandleCache[(( uintptr_t )pContext >> 4) & (HANDLE_CACHE_SIZE - 1)];
+}
+
+void ForgetCachedMap(const CMap *map) {
+	for( size_t i=0; i<HANDLE_CACHE_SIZE; i++ ) {
+		if( g_HandleCache[i].map==map ) {
+			g_HandleCache[i].ctx = NULL;
+			g_HandleCache[i].hndl = BAD_HANDLE;
+			g_HandleCache[i].map = NULL;
+		}
+	}
+}
+
+/// `ReadHandle` with a per-context cache in front of it.
+static HandleError ReadMapHandle(IPluginContext *pContext, const Handle_t hndl, CMap **map) {
+	HandleCacheSlot *slot = HandleCacheFor(pContext);
+	if( slot->ctx==pContext && slot->hndl==hndl && hndl != BAD_HANDLE ) {
+		*map = slot->map;
+		return HandleError_None;
+	}
+	
+	HandleSecurity sec = MakeHandleSec();
+	const HandleError err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )map);
+	if( err==HandleError_None && ( uintptr_t )hndl==(*map)->user ) {
+		slot->ctx = pContext;
+		slot->hndl = hndl;
+		slot->map = *map;
+	}
+	return err;
+}
+
 static char *GetParamString(IPluginContext *pContext, const cell_t param) {
 	char *key = NULL;
 	const int err = pContext->LocalToString(param, &key);
@@ -27,782 +73,1238 @@ static cell_t *GetCellAddr(IPluginContext *pContext, const cell_t param) {
 	return a;
 }
 
-/// OrdMap(int default_size = 8);
-static cell_t Native_OrdMap_Ctor(IPluginContext *pContext, const cell_t *params)
-{
-	if( params[1] < 0 ) {
-		pContext->ThrowNativeError("Invalid Default Size (%d) for OrdMap constructor", params[1]);
-		return BAD_HANDLE;
+/// a 2D array starts with one cell per row, each holding the byte offset from that cell to its row.
+/// returns the plugin address of row `i`.
+static cell_t ArrayRow(const cell_t param, const cell_t *rows, const size_t i) {
+	return param + ( cell_t )(i * sizeof(cell_t)) + rows[i];
+}
+
+/// resolves an `OrdMapKey` made by `OrdMapKey(const char[] key)`.
+static const MapInterned *GetKeyToken(IPluginContext *pContext, const cell_t token) {
+	const MapInterned *ik = map_key_pool_from_token(&g_KeyPool, ( uint32_t )token);
+	if( ik==NULL ) {
+		pContext->ThrowNativeError("Invalid OrdMapKey %d", token);
 	}
-	
-	const size_t default_size = ( size_t )params[1];
-	CMap *map = new_map(default_size);
-	if( map==nullptr )
-		return BAD_HANDLE;
-	
-	return g_pHandleSys->CreateHandle(g_OrdMapType, map, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+	return ik;
 }
 
-/// property int Len.get
-static cell_t Native_OrdMap_Len(IPluginContext *pContext, const cell_t *params)
-{
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
+/// SourceMod's int64 layout, `[0]` holds the low bits and `[1]` the high bits.
+static uint64_t CellsToInt64(const cell_t *key) {
+	return (( uint64_t )( uint32_t )key[1] << 32) | ( uint32_t )key[0];
+}
+
+/// reads `params[1]` as an OrdMap handle, throws and returns NULL if it isn't one.
+static CMap *GetMap(IPluginContext *pContext, const cell_t *params) {
+	const Handle_t hndl = static_cast< Handle_t >(params[1]);
 	CMap *map = NULL;
 	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
+	if( (err = ReadMapHandle(pContext, hndl, &map)) != HandleError_None ) {
 		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
+		return NULL;
 	}
-	return ( cell_t )map->vec.len;
+	return map;
 }
 
-/// bool HasKey(const char[] key);
-static cell_t Native_OrdMap_HasKey(IPluginContext *pContext, const cell_t *params)
-{
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
+/** key modes
+ * how a native's key argument (`params[2]`) is read, and how entries are found, created and removed by it.
+ * string, cell, int64 and token keys all become a `MapKeyView` and share one lookup path,
+ * index and id modes address existing entries only.
+ */
+struct NativeKey {
+	MapKeyView view;
+	size_t     index; /// index and id modes.
+};
+
+struct ViewKeyMode {
+	static MapEntry *Find(CMap *map, const NativeKey &key) {
+		return map_view_get(map, &key.view);
+	}
+	static MapEntry *Entry(CMap *map, const NativeKey &key, bool *inserted) {
+		return map_view_entry(map, &key.view, inserted);
+	}
+	static bool Remove(CMap *map, const NativeKey &key) {
+		return map_view_rm(map, &key.view);
+	}
+	/// a missing key is always an error for getters.
+	static bool Quiet(const CMap *map, const NativeKey &key) {
+		return false;
+	}
+	static void Describe(const NativeKey &key, char *buf, const size_t len) {
+		switch( key.view.type ) {
+			case CellKey:
+				snprintf(buf, len, "key '%d'", ( cell_t )key.view.num); break;
+			case WideKey:
+				snprintf(buf, len, "key '{%d, %d}'", ( cell_t )( uint32_t )key.view.num, ( cell_t )( uint32_t )(key.view.num >> 32)); break;
+			default:
+				snprintf(buf, len, "key '%s'", key.view.str); break;
+		}
+	}
+};
+
+struct StrKeyMode : ViewKeyMode {
+	static bool Read(IPluginContext *pContext, const CMap *map, const cell_t param, NativeKey *key) {
+		char *str = GetParamString(pContext, param);
+		if( str==NULL )
+			return false; /// already threw error msg.
+		
+		key->view = map_str_key(str);
+		return true;
+	}
+};
+
+struct CellKeyMode : ViewKeyMode {
+	static bool Read(IPluginContext *pContext, const CMap *map, const cell_t param, NativeKey *key) {
+		key->view = map_cell_key(param);
+		return true;
+	}
+};
+
+struct Int64KeyMode : ViewKeyMode {
+	static bool Read(IPluginContext *pContext, const CMap *map, const cell_t param, NativeKey *key) {
+		const cell_t *cells = GetCellAddr(pContext, param);
+		if( cells==NULL )
+			return false;
+		
+		key->view = map_wide_key(CellsToInt64(cells));
+		return true;
+	}
+};
+
+struct TokenMode : ViewKeyMode {
+	static bool Read(IPluginContext *pContext, const CMap *map, const cell_t param, NativeKey *key) {
+		const MapInterned *ik = GetKeyToken(pContext, param);
+		if( ik==NULL )
+			return false;
+		
+		key->view = map_token_key(map, ik);
+		return true;
+	}
+};
+
+struct IndexMode {
+	static bool Read(IPluginContext *pContext, const CMap *map, const cell_t param, NativeKey *key) {
+		if( param < 0 ) {
+			pContext->ThrowNativeError("cannot use negative index (%d) for OrdMap", param);
+			return false;
+		}
+		key->index = ( size_t )param;
+		return true;
+	}
+	static MapEntry *Find(CMap *map, const NativeKey &key) {
+		return map_idx_get(map, key.index);
+	}
+	static MapEntry *Entry(CMap *map, const NativeKey &key, bool *inserted) {
+		*inserted = false;
+		return map_idx_get(map, key.index);
 	}
+	static bool Remove(CMap *map, const NativeKey &key) {
+		return map_idx_rm(map, key.index);
+	}
+	/// removed entry of a stable-index map, skip quietly.
+	static bool Quiet(const CMap *map, const NativeKey &key) {
+		return key.index < map_span(map);
+	}
+	static void Describe(const NativeKey &key, char *buf, const size_t len) {
+		snprintf(buf, len, "index '%zu'", key.index);
+	}
+};
+
+struct IdMode {
+	static bool Read(IPluginContext *pContext, const CMap *map, const cell_t param, NativeKey *key) {
+		key->index = ( uint32_t )param;
+		return true;
+	}
+	static MapEntry *Find(CMap *map, const NativeKey &key) {
+		return map_id_get(map, ( uint32_t )key.index);
+	}
+	static MapEntry *Entry(CMap *map, const NativeKey &key, bool *inserted) {
+		*inserted = false;
+		return map_id_get(map, ( uint32_t )key.index);
+	}
+	static bool Remove(CMap *map, const NativeKey &key) {
+		return map_id_rm(map, ( uint32_t )key.index);
+	}
+	/// a stale id is an expected outcome, not an error.
+	static bool Quiet(const CMap *map, const NativeKey &key) {
+		return true;
+	}
+	static void Describe(const NativeKey &key, char *buf, const size_t len) {
+		snprintf(buf, len, "id '%d'", ( cell_t )key.index);
+	}
+};
+
+
+/** value types
+ * how a native's value argument (`params[3]`, plus `params[4]` for lengths) is read, stored and copied back out.
+ */
+struct NativeValue {
+	const uint8_t *data;
+	size_t         len;
+	cell_t         item;
+};
+
+struct CellValue {
+	static const MapEntryType Tag = CellEntry;
+	static const char *Type() { return "a cell"; }
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
-		return 0; /// already threw error msg.
+	static bool CheckGet(IPluginContext *pContext, const cell_t *params) {
+		return true;
+	}
+	static bool Read(IPluginContext *pContext, const cell_t *params, NativeValue *val) {
+		val->item = params[3];
+		return true;
+	}
+	static bool Store(CMap *map, MapEntry *entry, const NativeValue &val) {
+		return map_assign(map, entry, CellEntry, entry_data_from_int(val.item));
+	}
+	static bool Fits(const MapEntry *entry, const cell_t *params) {
+		return true;
+	}
+	static bool Load(IPluginContext *pContext, const MapEntry *entry, const cell_t *params) {
+		cell_t *item = GetCellAddr(pContext, params[3]);
+		if( item==NULL )
+			return false;
+		
+		*item = entry->data.i;
+		return true;
+	}
+};
+
+/// arrays and strings both take a buffer length in `params[4]` when read back.
+struct BufferValue {
+	static bool CheckGet(IPluginContext *pContext, const cell_t *params) {
+		if( params[4] < 0 ) {
+			pContext->ThrowNativeError("cannot use negative length (%d) as buffer length for OrdMap", params[4]);
+			return false;
+		}
+		return true;
+	}
+	/// only allow an equal or larger buffer size.
+	static bool Fits(const MapEntry *entry, const cell_t *params) {
+		return entry->data.a.len <= ( size_t )params[4];
+	}
+};
+
+struct ArrayValue : BufferValue {
+	static const MapEntryType Tag = ArrayEntry;
+	static const char *Type() { return "an array"; }
 	
-	return( cell_t )map_has_key(map, key);
+	static bool Read(IPluginContext *pContext, const cell_t *params, NativeValue *val) {
+		if( !CheckGet(pContext, params) )
+			return false;
+		
+		cell_t *array = GetCellAddr(pContext, params[3]);
+		if( array==NULL )
+			return false;
+		
+		val->data = ( const uint8_t* )array;
+		val->len = ( size_t )params[4];
+		return true;
+	}
+	static bool Store(CMap *map, MapEntry *entry, const NativeValue &val) {
+		return map_set_array(map, entry, ArrayEntry, val.data, sizeof(cell_t), val.len);
+	}
+	static cell_t Length(const MapEntry *entry) {
+		return ( cell_t )entry->data.a.len;
+	}
+	/// copies the entry's cells only, the rest of a larger buffer is left as is.
+	static bool Load(IPluginContext *pContext, const MapEntry *entry, const cell_t *params) {
+		cell_t *items = GetCellAddr(pContext, params[3]);
+		if( items==NULL )
+			return false;
+		
+		map_value_read(&entry->data.a, sizeof(cell_t), 0, items, entry->data.a.len);
+		return true;
+	}
+};
+
+struct StrValue : BufferValue {
+	static const MapEntryType Tag = StrEntry;
+	static const char *Type() { return "a string"; }
+	
+	static bool Read(IPluginContext *pContext, const cell_t *params, NativeValue *val) {
+		char *str = GetParamString(pContext, params[3]);
+		if( str==NULL )
+			return false;
+		
+		val->data = ( const uint8_t* )str;
+		val->len = 0; /// measured when stored.
+		return true;
+	}
+	static bool Store(CMap *map, MapEntry *entry, const NativeValue &val) {
+		return map_set_array(map, entry, StrEntry, val.data, sizeof(char), val.len);
+	}
+	/// includes the null terminator so it can size a buffer.
+	static cell_t Length(const MapEntry *entry) {
+		return ( cell_t )entry->data.a.len + 1;
+	}
+	/// the string needs room for its null terminator too.
+	static bool Fits(const MapEntry *entry, const cell_t *params) {
+		return entry->data.a.len < ( size_t )params[4];
+	}
+	static bool Load(IPluginContext *pContext, const MapEntry *entry, const cell_t *params) {
+		char *buf = GetParamString(pContext, params[3]);
+		if( buf==NULL )
+			return false;
+		
+		memcpy(buf, map_value_data(&entry->data.a), entry->data.a.len + 1);
+		return true;
+	}
+};
+
+
+/// throws `fmt` with the key's description and `type` filled in.
+template< typename Mode >
+static void ThrowEntryError(IPluginContext *pContext, const NativeKey &key, const char *fmt, const char *type = "") {
+	char desc[64];
+	Mode::Describe(key, desc, sizeof desc);
+	pContext->ThrowNativeError(fmt, desc, type);
 }
 
-/// bool InsertCell(const char[] key, any item);
-static cell_t Native_OrdMap_InsertCell(IPluginContext *pContext, const cell_t *params)
-{
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
+/// finds the entry a getter reads and checks its type, `InvalidEntry` accepts any type.
+/// returns NULL after throwing, or quietly when the mode allows a missing entry.
+template< typename Mode >
+static MapEntry *FindEntry(IPluginContext *pContext, CMap *map, const NativeKey &key, const MapEntryType tag, const char *type) {
+	MapEntry *entry = Mode::Find(map, key);
+	if( entry==nullptr ) {
+		if( !Mode::Quiet(map, key) )
+			ThrowEntryError< Mode >(pContext, key, "Unable to retrieve OrdMap entry for %s");
+		return nullptr;
+	} else if( tag != InvalidEntry && entry->tag != tag ) {
+		ThrowEntryError< Mode >(pContext, key, "OrdMap entry %s is not %s type", type);
+		return nullptr;
 	}
-	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
-		return 0;
-	
-	union MapEntryData d;
-	d.i = params[3];
-	return ( cell_t )map_insert(map, key, CellEntry, d);
+	return entry;
 }
 
-/// bool InsertArray(const char[] key, const any[] items, int len);
-static cell_t Native_OrdMap_InsertArray(IPluginContext *pContext, const cell_t *params)
+/// bool Has*(key);
+template< typename Mode >
+static cell_t Native_Has(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
-	}
-	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
-		return 0;
-	
-	cell_t *array = GetCellAddr(pContext, params[3]);
-	if( array==NULL )
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
 	
-	const size_t array_len = ( size_t )params[4];
-	union MapEntryData d = entry_data_from_array(( uint8_t* )array, sizeof(cell_t), array_len, false);
-	return ( cell_t )map_insert(map, key, ArrayEntry, d);
+	return( cell_t )(Mode::Find(map, key) != nullptr);
 }
 
-/// bool InsertString(const char[] key, const char[] str);
-static cell_t Native_OrdMap_InsertString(IPluginContext *pContext, const cell_t *params)
+/// bool *Insert*(key, value[, int len]);
+/// returns false if the key exists.
+template< typename Mode, typename Value >
+static cell_t Native_Insert(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	NativeValue val;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) || !Value::Read(pContext, params, &val) )
 		return 0;
-	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
+	/// only copy the value once we know the key was free.
+	bool inserted = false;
+	MapEntry *entry = Mode::Entry(map, key, &inserted);
+	if( entry==nullptr || !inserted )
 		return 0;
 	
-	char *str = GetParamString(pContext, params[3]);
-	if( str==NULL )
+	/// a key without a value would be left behind as an `InvalidEntry`.
+	if( !Value::Store(map, entry, val) ) {
+		map_entry_rm(map, entry);
 		return 0;
-	
-	union MapEntryData d = entry_data_from_array(( uint8_t* )str, sizeof(char), 0, true);
-	return ( cell_t )map_insert(map, key, StrEntry, d);
+	}
+	return 1;
 }
 
-/// bool GetCellByKey(const char[] key, any& item);
-static cell_t Native_OrdMap_GetCellByKey(IPluginContext *pContext, const cell_t *params)
+/// bool Set*By*(key, value[, int len]);
+/// creates the entry for key modes, index and id modes only overwrite existing entries.
+template< typename Mode, typename Value >
+static cell_t Native_Set(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	NativeValue val;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) || !Value::Read(pContext, params, &val) )
 		return 0;
-	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
-		return 0;
-	
-	MapEntry *entry = map_key_get(map, key);
+	bool inserted = false;
+	MapEntry *entry = Mode::Entry(map, key, &inserted);
 	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for key '%s'", key);
 		return 0;
-	} else if( entry->tag != CellEntry ) {
-		pContext->ThrowNativeError("OrdMap entry '%s' is not a cell type", key);
+	} else if( !Value::Store(map, entry, val) ) {
+		if( inserted )
+			map_entry_rm(map, entry);
 		return 0;
 	}
-	
-	cell_t *item = GetCellAddr(pContext, params[3]);
-	if( item==NULL )
-		return 0;
-	
-	*item = entry->data.i;
 	return 1;
 }
 
-/// bool GetCellByIndex(int index, any& item);
-static cell_t Native_OrdMap_GetCellByIndex(IPluginContext *pContext, const cell_t *params)
+/// bool Get*By*(key, value&[, int len]);
+template< typename Mode, typename Value >
+static cell_t Native_Get(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
-	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to get a cell from OrdMap", params[2]);
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Value::CheckGet(pContext, params) || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	}
 	
-	const size_t index = ( size_t )params[2];
-	MapEntry *entry = map_idx_get(map, index);
+	const MapEntry *entry = FindEntry< Mode >(pContext, map, key, Value::Tag, Value::Type());
 	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for index '%zu'", index);
 		return 0;
-	} else if( entry->tag != CellEntry ) {
-		pContext->ThrowNativeError("OrdMap entry index '%zu' is not a cell type", index);
+	} else if( !Value::Fits(entry, params) ) {
+		ThrowEntryError< Mode >(pContext, key, "buffer is too small for OrdMap entry %s");
 		return 0;
 	}
-	
-	cell_t *item = GetCellAddr(pContext, params[3]);
-	if( item==NULL )
+	return ( cell_t )Value::Load(pContext, entry, params);
+}
+
+/// int Get*LenBy*(key);
+template< typename Mode, typename Value >
+static cell_t Native_Len(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
 	
-	*item = entry->data.i;
-	return 1;
+	const MapEntry *entry = FindEntry< Mode >(pContext, map, key, Value::Tag, Value::Type());
+	return( entry != nullptr )? Value::Length(entry) : 0;
 }
 
-/// int GetArrayLenByKey(const char[] key);
-static cell_t Native_OrdMap_GetArrayLenByKey(IPluginContext *pContext, const cell_t *params)
+/// MapEntryType GetEntryTypeBy*(key);
+template< typename Mode >
+static cell_t Native_EntryType(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
+	const MapEntry *entry = FindEntry< Mode >(pContext, map, key, InvalidEntry, "");
+	return( entry != nullptr )? ( cell_t )entry->tag : ( cell_t )InvalidEntry;
+}
+
+/// bool RemoveBy*(key);
+template< typename Mode >
+static cell_t Native_Remove(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
 	
-	MapEntry *entry = map_key_get(map, key);
-	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for key '%s'", key);
-		return 0;
-	} else if( entry->tag != ArrayEntry ) {
-		pContext->ThrowNativeError("OrdMap entry '%s' is not an array type", key);
-		return 0;
-	}
-	return( cell_t )entry->data.a.len;
+	return ( cell_t )Mode::Remove(map, key);
 }
 
-/// int GetArrayLenByIndex(int index);
-static cell_t Native_OrdMap_GetArrayLenByIndex(IPluginContext *pContext, const cell_t *params)
+/** cell ops
+ * read-modify-write updates of a cell entry, `Apply` gets the current value and the operand.
+ * a new entry has no current value, `Apply` gets `fresh` set and `cur` as 0 then.
+ * sums wrap around like Pawn's own integer math.
+ */
+struct AddOp {
+	static cell_t Operand(const cell_t *params) { return params[3]; }
+	static cell_t Apply(const cell_t cur, const cell_t v, const bool fresh) {
+		return ( cell_t )(( uint32_t )cur + ( uint32_t )v);
+	}
+};
+
+struct IncrementOp : AddOp {
+	static cell_t Operand(const cell_t *params) { return 1; }
+};
+
+struct MinOp {
+	static cell_t Operand(const cell_t *params) { return params[3]; }
+	static cell_t Apply(const cell_t cur, const cell_t v, const bool fresh) {
+		return( fresh || v < cur )? v : cur;
+	}
+};
+
+struct MaxOp {
+	static cell_t Operand(const cell_t *params) { return params[3]; }
+	static cell_t Apply(const cell_t cur, const cell_t v, const bool fresh) {
+		return( fresh || v > cur )? v : cur;
+	}
+};
+
+/// int AddCellBy*(key, int amount);
+/// int IncrementCellBy*(key);
+/// int MinCellBy*(key, int item), int MaxCellBy*(key, int item);
+/// finds or creates the entry in one probe and updates it in place, returns the new value.
+/// index mode only updates existing entries.
+template< typename Mode, typename Op >
+static cell_t Native_UpdateCell(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to get array length from OrdMap", params[2]);
-		return 0;
-	}
 	
-	const size_t index = ( size_t )params[2];
-	MapEntry *entry = map_idx_get(map, index);
+	bool inserted = false;
+	MapEntry *entry = Mode::Entry(map, key, &inserted);
 	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for index '%zu'", index);
-		return 0;
-	} else if( entry->tag != ArrayEntry ) {
-		pContext->ThrowNativeError("OrdMap entry index '%zu' is not an array type", index);
+		if( !Mode::Quiet(map, key) )
+			ThrowEntryError< Mode >(pContext, key, "Unable to retrieve OrdMap entry for %s");
 		return 0;
 	}
-	return( cell_t )entry->data.a.len;
-}
-
-/// int GetStringLenByKey(const char[] key);
-static cell_t Native_OrdMap_GetStringLenByKey(IPluginContext *pContext, const cell_t *params)
-{
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
 	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	const bool fresh = entry->tag==InvalidEntry;
+	if( !fresh && entry->tag != CellEntry ) {
+		ThrowEntryError< Mode >(pContext, key, "OrdMap entry %s is not %s type", CellValue::Type());
 		return 0;
 	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
+	const cell_t item = Op::Apply(fresh? 0 : entry->data.i, Op::Operand(params), fresh);
+	if( fresh )
+		map_assign(map, entry, CellEntry, entry_data_from_int(item));
+	else
+		entry->data.i = item;
+	return item;
+}
+
+/// bool CompareAndSetCellBy*(key, any expected, any item);
+/// sets the entry to `item` only if it holds `expected`, a missing entry never matches.
+template< typename Mode >
+static cell_t Native_CompareAndSetCell(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
 	
-	MapEntry *entry = map_key_get(map, key);
+	MapEntry *entry = Mode::Find(map, key);
 	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for key '%s'", key);
 		return 0;
-	} else if( entry->tag != StrEntry ) {
-		pContext->ThrowNativeError("OrdMap entry '%s' is not a string type", key);
+	} else if( entry->tag != CellEntry ) {
+		ThrowEntryError< Mode >(pContext, key, "OrdMap entry %s is not %s type", CellValue::Type());
+		return 0;
+	} else if( entry->data.i != params[3] ) {
 		return 0;
 	}
-	return( cell_t )entry->data.a.len + 1;
+	entry->data.i = params[4];
+	return 1;
 }
 
-/// int GetStringLenByIndex(int index);
-static cell_t Native_OrdMap_GetStringLenByIndex(IPluginContext *pContext, const cell_t *params)
-{
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
-	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to get string length from OrdMap", params[2]);
-		return 0;
-	}
-	
-	const size_t index = ( size_t )params[2];
-	MapEntry *entry = map_idx_get(map, index);
+/// grows the array or string entry for `key` by `n` elements of `arr`, creating it if it's missing.
+/// returns the new length, or 0 after throwing.
+template< typename Mode, typename Value >
+static cell_t AppendEntry(IPluginContext *pContext, CMap *map, const NativeKey &key, const uint8_t *arr, const size_t elen, const size_t n) {
+	bool inserted = false;
+	MapEntry *entry = Mode::Entry(map, key, &inserted);
 	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for index '%zu'", index);
+		if( !Mode::Quiet(map, key) )
+			ThrowEntryError< Mode >(pContext, key, "Unable to retrieve OrdMap entry for %s");
+		return 0;
+	} else if( entry->tag != InvalidEntry && entry->tag != Value::Tag ) {
+		ThrowEntryError< Mode >(pContext, key, "OrdMap entry %s is not %s type", Value::Type());
 		return 0;
-	} else if( entry->tag != StrEntry ) {
-		pContext->ThrowNativeError("OrdMap entry index '%zu' is not a string type", index);
+	} else if( !map_append_array(map, entry, Value::Tag, arr, elen, n) ) {
+		ThrowEntryError< Mode >(pContext, key, "out of memory growing OrdMap entry %s");
+		if( inserted )
+			map_entry_rm(map, entry);
 		return 0;
 	}
-	return( cell_t )entry->data.a.len + 1;
+	return ( cell_t )entry->data.a.len;
 }
 
-/// bool GetArrayByKey(const char[] key, any[] items, int len);
-static cell_t Native_OrdMap_GetArrayByKey(IPluginContext *pContext, const cell_t *params)
+/// int PushArrayBy*(key, any item);
+/// the array's buffer grows geometrically, so pushing is amortized O(1).
+template< typename Mode >
+static cell_t Native_PushArray(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	} else if( params[4] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative length (%d) as buffer length for OrdMap", params[4]);
+	
+	return AppendEntry< Mode, ArrayValue >(pContext, map, key, ( const uint8_t* )&params[3], sizeof(cell_t), 1);
+}
+
+/// bool PopArrayBy*(key, any& item);
+template< typename Mode >
+static cell_t Native_PopArray(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
+	MapEntry *entry = FindEntry< Mode >(pContext, map, key, ArrayEntry, ArrayValue::Type());
+	if( entry==nullptr )
 		return 0;
 	
-	MapEntry *entry = map_key_get(map, key);
-	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for key '%s'", key);
+	cell_t *item = GetCellAddr(pContext, params[3]);
+	if( item==NULL )
 		return 0;
-	} else if( entry->tag != ArrayEntry ) {
-		pContext->ThrowNativeError("OrdMap entry key '%s' is not an array type", key);
+	
+	return ( cell_t )map_value_pop(&entry->data.a, sizeof(cell_t), item);
+}
+
+/// int AppendStringBy*(key, const char[] str);
+template< typename Mode >
+static cell_t Native_AppendString(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	}
 	
-	/// only allow an equal or larger buffer size.
-	const size_t given_len = ( size_t )params[4];
-	if( entry->data.a.len > given_len ) {
-		pContext->ThrowNativeError("buffer is too small for array entry of key '%s'", key);
+	const char *str = GetParamString(pContext, params[3]);
+	if( str==NULL )
 		return 0;
-	}
 	
-	cell_t *item = NULL;
-	pContext->LocalToPhysAddr(params[3], &item);
-	const cell_t *datum = ( const cell_t* )entry->data.a.table;
-	for( size_t i=0; i<given_len; i++ ) {
-		item[i] = datum[i];
+	return AppendEntry< Mode, StrValue >(pContext, map, key, ( const uint8_t* )str, sizeof(char), strlen(str));
+}
+
+/// finds the array entry an element or slice native works on and checks `offset` lies within it.
+/// an element has to exist, a slice may start right at the end and be empty.
+template< typename Mode >
+static MapEntry *FindArraySpan(IPluginContext *pContext, CMap *map, const NativeKey &key, const cell_t offset, const cell_t len, const bool element) {
+	MapEntry *entry = FindEntry< Mode >(pContext, map, key, ArrayEntry, ArrayValue::Type());
+	if( entry==nullptr )
+		return nullptr;
+	
+	const size_t array_len = entry->data.a.len;
+	if( len < 0 ) {
+		pContext->ThrowNativeError("cannot use negative length (%d) as buffer length for OrdMap", len);
+		return nullptr;
+	} else if( offset < 0 || ( size_t )offset > array_len || (element && ( size_t )offset==array_len) ) {
+		char desc[64];
+		Mode::Describe(key, desc, sizeof desc);
+		pContext->ThrowNativeError("index %d is out of bounds for OrdMap entry %s of length %zu", offset, desc, array_len);
+		return nullptr;
 	}
-	return 1;
+	return entry;
 }
 
-/// bool GetArrayByIndex(int index, any[] items, int len);
-static cell_t Native_OrdMap_GetArrayByIndex(IPluginContext *pContext, const cell_t *params)
+/// bool GetArrayElement*(key, int index, any& item);
+template< typename Mode >
+static cell_t Native_GetArrayElement(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
-	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to get array from OrdMap", params[2]);
-		return 0;
-	} else if( params[4] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative length (%d) as buffer length from OrdMap", params[4]);
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	}
 	
-	const size_t index = ( size_t )params[2];
-	MapEntry *entry = map_idx_get(map, index);
-	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for index '%zu'", index);
-		return 0;
-	} else if( entry->tag != ArrayEntry ) {
-		pContext->ThrowNativeError("OrdMap entry index '%zu' is not an array type", index);
+	const MapEntry *entry = FindArraySpan< Mode >(pContext, map, key, params[3], 1, true);
+	if( entry==nullptr )
 		return 0;
-	}
 	
-	/// only allow an equal or larger buffer size.
-	const size_t given_len = ( size_t )params[4];
-	if( entry->data.a.len > given_len ) {
-		pContext->ThrowNativeError("buffer is too small for array entry of index '%zu'", index);
+	cell_t *item = GetCellAddr(pContext, params[4]);
+	if( item==NULL )
 		return 0;
-	}
 	
-	cell_t *item = NULL;
-	pContext->LocalToPhysAddr(params[3], &item);
-	const cell_t *datum = ( const cell_t* )entry->data.a.table;
-	for( size_t i=0; i<given_len; i++ ) {
-		item[i] = datum[i];
-	}
-	return 1;
+	return ( cell_t )map_value_read(&entry->data.a, sizeof(cell_t), ( size_t )params[3], item, 1);
 }
 
-/// bool GetStringByKey(const char[] key, char[] buffer, int len);
-static cell_t Native_OrdMap_GetStringByKey(IPluginContext *pContext, const cell_t *params)
+/// bool SetArrayElement*(key, int index, any item);
+/// writes the one cell in place, the array keeps its length and buffer.
+template< typename Mode >
+static cell_t Native_SetArrayElement(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
-	} else if( params[4] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative length (%d) as buffer length for OrdMap", params[4]);
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
+	MapEntry *entry = FindArraySpan< Mode >(pContext, map, key, params[3], 1, true);
+	if( entry==nullptr )
 		return 0;
 	
-	MapEntry *entry = map_key_get(map, key);
-	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for key '%s'", key);
-		return 0;
-	} else if( entry->tag != StrEntry ) {
-		pContext->ThrowNativeError("OrdMap entry key '%s' is not a string type", key);
+	return ( cell_t )map_value_write(&entry->data.a, sizeof(cell_t), ( size_t )params[3], &params[4], 1);
+}
+
+/// int GetArraySlice*(key, int offset, any[] items, int len);
+/// returns how many cells were copied, fewer than `len` when the array ends first.
+template< typename Mode >
+static cell_t Native_GetArraySlice(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	}
 	
-	/// only allow an equal or larger buffer size.
-	const size_t given_len = ( size_t )params[4];
-	if( entry->data.a.len > given_len ) {
-		pContext->ThrowNativeError("buffer is too small for string entry of key '%s'", key);
+	const MapEntry *entry = FindArraySpan< Mode >(pContext, map, key, params[3], params[5], false);
+	if( entry==nullptr )
 		return 0;
-	}
 	
-	char *buf = GetParamString(pContext, params[3]);
-	if( buf==NULL )
+	cell_t *items = GetCellAddr(pContext, params[4]);
+	if( items==NULL )
 		return 0;
 	
-	const char *datum = ( const char* )entry->data.a.table;
-	for( size_t i=0; i<given_len; i++ ) {
-		buf[i] = datum[i];
-	}
-	return 1;
+	return ( cell_t )map_value_read(&entry->data.a, sizeof(cell_t), ( size_t )params[3], items, ( size_t )params[5]);
 }
 
-/// bool GetStringByIndex(int index, char[] buffer, int len);
-static cell_t Native_OrdMap_GetStringByIndex(IPluginContext *pContext, const cell_t *params)
+/// int SetArraySlice*(key, int offset, const any[] items, int len);
+/// overwrites in place and never grows the array, returns how many cells were written.
+template< typename Mode >
+static cell_t Native_SetArraySlice(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
 		return 0;
-	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to get string from OrdMap", params[2]);
-		return 0;
-	} else if( params[4] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative length (%d) as buffer length from OrdMap", params[4]);
-		return 0;
-	}
 	
-	const size_t index = ( size_t )params[2];
-	MapEntry *entry = map_idx_get(map, index);
-	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for index '%zu'", index);
+	MapEntry *entry = FindArraySpan< Mode >(pContext, map, key, params[3], params[5], false);
+	if( entry==nullptr )
 		return 0;
-	} else if( entry->tag != StrEntry ) {
-		pContext->ThrowNativeError("OrdMap entry index '%zu' is not a string type", index);
-		return 0;
-	}
 	
-	/// only allow an equal or larger buffer size.
-	const size_t given_len = ( size_t )params[4];
-	if( entry->data.a.len > given_len ) {
-		pContext->ThrowNativeError("buffer is too small for array entry of index '%zu'", index);
-		return 0;
-	}
-	char *buf = GetParamString(pContext, params[3]);
-	if( buf==NULL )
+	const cell_t *items = GetCellAddr(pContext, params[4]);
+	if( items==NULL )
 		return 0;
-		
-	const char *datum = ( const char* )entry->data.a.table;
-	for( size_t i=0; i<given_len; i++ ) {
-		buf[i] = datum[i];
-	}
-	return 1;
+	
+	return ( cell_t )map_value_write(&entry->data.a, sizeof(cell_t), ( size_t )params[3], items, ( size_t )params[5]);
 }
 
-/// bool SetCellByKey(const char[] key, any item);
-static cell_t Native_OrdMap_SetCellByKey(IPluginContext *pContext, const cell_t *params)
+
+/// OrdMap(int default_size = 8, OrdMapFlags flags = OrdMapDefault);
+static cell_t Native_OrdMap_Ctor(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
+	if( params[1] < 0 || ( size_t )params[1] > map_max_entries() ) {
+		pContext->ThrowNativeError("Invalid Default Size (%d) for OrdMap constructor", params[1]);
+		return BAD_HANDLE;
 	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
-		return 0;
+	const size_t default_size = ( size_t )params[1];
+	/// plugins compiled before `flags` existed only pass the size.
+	const uint32_t flags = ( params[0] >= 2 )? ( uint32_t )params[2] : MapDefault;
+	CMap *map = new_map(default_size, flags, &g_KeyPool);
+	if( map==nullptr )
+		return BAD_HANDLE;
 	
-	union MapEntryData d;
-	d.i = params[3];
-	return ( cell_t )map_key_set(map, key, CellEntry, d);
+	const Handle_t hndl = g_pHandleSys->CreateHandle(g_OrdMapType, map, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+	if( hndl==BAD_HANDLE )
+		map_free(&map);
+	else
+		map->user = hndl;
+	return hndl;
 }
 
-/// bool SetCellByIndex(int index, any item);
-static cell_t Native_OrdMap_SetCellByIndex(IPluginContext *pContext, const cell_t *params)
+/// OrdMapKey(const char[] key);
+static cell_t Native_OrdMapKey_Ctor(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
+	char *key = GetParamString(pContext, params[1]);
+	if( key==NULL )
+		return 0; /// already threw error msg.
 	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
-		return 0;
-	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to set a cell from OrdMap", params[2]);
-		return 0;
-	}
-	const size_t index = ( size_t )params[2];
-	union MapEntryData d;
-	d.i = params[3];
-	return ( cell_t )map_idx_set(map, index, CellEntry, d);
+	const MapKeyView v = map_str_key(key);
+	return ( cell_t )map_key_pool_token(&g_KeyPool, &v);
 }
 
-/// bool SetArrayByKey(const char[] key, const any[] items, int len);
-static cell_t Native_OrdMap_SetArrayByKey(IPluginContext *pContext, const cell_t *params)
+/// property int Len.get
+static cell_t Native_OrdMap_Len(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL )
 		return 0;
-	}
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
-		return 0;
-	
-	cell_t *array = GetCellAddr(pContext, params[3]);
-	if( array==NULL )
+	return ( cell_t )map_span(map);
+}
+
+/// property int Count.get
+static cell_t Native_OrdMap_Count(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL )
 		return 0;
+	return ( cell_t )map->len;
+}
 
-	const size_t array_len = ( size_t )params[4];
-	union MapEntryData d = entry_data_from_array(( uint8_t* )array, sizeof(cell_t), array_len, false);
-	return ( cell_t )map_key_set(map, key, ArrayEntry, d);
+/// property int Capacity.get
+static cell_t Native_OrdMap_Capacity(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL )
+		return 0;
+	return ( cell_t )map_capacity(map);
 }
 
-/// bool SetArrayByIndex(int index, const any[] items, int len);
-static cell_t Native_OrdMap_SetArrayByIndex(IPluginContext *pContext, const cell_t *params)
+/// bool Reserve(int entries);
+static cell_t Native_OrdMap_Reserve(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL ) {
 		return 0;
 	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to set array from OrdMap", params[2]);
+		pContext->ThrowNativeError("cannot reserve a negative amount (%d) of OrdMap entries", params[2]);
 		return 0;
-	} else if( params[4] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative length (%d) as buffer length from OrdMap", params[4]);
+	} else if( ( size_t )params[2] > map_max_entries() ) {
+		pContext->ThrowNativeError("cannot reserve %d entries", params[2]);
 		return 0;
 	}
-	const size_t index = ( size_t )params[2];
-	
-	cell_t *array = GetCellAddr(pContext, params[3]);
-	if( array==NULL )
-		return 0;
-
-	const size_t array_len = ( size_t )params[4];
-	union MapEntryData d = entry_data_from_array(( uint8_t* )array, sizeof(cell_t), array_len, false);
-	return ( cell_t )map_idx_set(map, index, ArrayEntry, d);
+	return ( cell_t )map_reserve(map, ( size_t )params[2]);
 }
 
-/// bool SetStringByKey(const char[] key, const char[] str);
-static cell_t Native_OrdMap_SetStringByKey(IPluginContext *pContext, const cell_t *params)
+/// int InsertCells(const char[][] keys, const any[] items, int n);
+static cell_t Native_OrdMap_InsertCells(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL ) {
+		return 0;
+	} else if( params[4] < 0 ) {
+		pContext->ThrowNativeError("cannot insert a negative amount (%d) of OrdMap entries", params[4]);
+		return 0;
+	} else if( ( size_t )params[4] > map_max_entries() - map->len ) {
+		pContext->ThrowNativeError("cannot insert %d entries", params[4]);
 		return 0;
 	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
+	cell_t *rows = GetCellAddr(pContext, params[2]);
+	cell_t *items = GetCellAddr(pContext, params[3]);
+	if( rows==NULL || items==NULL )
 		return 0;
 	
-	char *str = GetParamString(pContext, params[3]);
-	if( str==NULL )
+	/// presizing once keeps the whole batch free of rehashes.
+	const size_t n = ( size_t )params[4];
+	if( !map_prepare_insert(map, n) ) {
+		pContext->ThrowNativeError("unable to make room for %d OrdMap entries", params[4]);
 		return 0;
+	}
 	
-	union MapEntryData d = entry_data_from_array(( uint8_t* )str, sizeof(char), 0, true);
-	return ( cell_t )map_key_set(map, key, StrEntry, d);
+	cell_t count = 0;
+	for( size_t i=0; i<n; i++ ) {
+		char *key = GetParamString(pContext, ArrayRow(params[2], rows, i));
+		if( key==NULL )
+			return count;
+		
+		bool inserted = false;
+		MapEntry *entry = map_key_entry(map, key, &inserted);
+		if( entry==nullptr )
+			return count;
+		else if( !inserted )
+			continue;
+		else if( map_assign(map, entry, CellEntry, entry_data_from_int(items[i])) )
+			count++;
+		else
+			map_entry_rm(map, entry);
+	}
+	return count;
 }
 
-/// bool SetStringByIndex(int index, const char[] str);
-static cell_t Native_OrdMap_SetStringByIndex(IPluginContext *pContext, const cell_t *params)
+/// int InsertArrays(const char[][] keys, const any[][] items, int n, int len);
+static cell_t Native_OrdMap_InsertArrays(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL ) {
+		return 0;
+	} else if( params[4] < 0 ) {
+		pContext->ThrowNativeError("cannot insert a negative amount (%d) of OrdMap entries", params[4]);
+		return 0;
+	} else if( ( size_t )params[4] > map_max_entries() - map->len ) {
+		pContext->ThrowNativeError("cannot insert %d entries", params[4]);
+		return 0;
+	} else if( params[5] < 0 ) {
+		pContext->ThrowNativeError("cannot use negative length (%d) as buffer length for OrdMap", params[5]);
+		return 0;
+	}
 	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	cell_t *rows = GetCellAddr(pContext, params[2]);
+	cell_t *item_rows = GetCellAddr(pContext, params[3]);
+	if( rows==NULL || item_rows==NULL )
 		return 0;
-	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to set string from OrdMap", params[2]);
+	
+	const size_t n = ( size_t )params[4];
+	const size_t array_len = ( size_t )params[5];
+	if( !map_prepare_insert(map, n) ) {
+		pContext->ThrowNativeError("unable to make room for %d OrdMap entries", params[4]);
 		return 0;
 	}
-	const size_t index = ( size_t )params[2];
-	char *str = NULL;
-	pContext->LocalToString(params[3], &str);
-	union MapEntryData d = entry_data_from_array(( uint8_t* )str, sizeof(char), 0, true);
-	return ( cell_t )map_idx_set(map, index, StrEntry, d);
+	
+	cell_t count = 0;
+	for( size_t i=0; i<n; i++ ) {
+		char *key = GetParamString(pContext, ArrayRow(params[2], rows, i));
+		cell_t *array = GetCellAddr(pContext, ArrayRow(params[3], item_rows, i));
+		if( key==NULL || array==NULL )
+			return count;
+		
+		bool inserted = false;
+		MapEntry *entry = map_key_entry(map, key, &inserted);
+		if( entry==nullptr )
+			return count;
+		else if( !inserted )
+			continue;
+		else if( map_set_array(map, entry, ArrayEntry, ( const uint8_t* )array, sizeof(cell_t), array_len) )
+			count++;
+		else
+			map_entry_rm(map, entry);
+	}
+	return count;
 }
 
-/// MapEntryType GetEntryTypeByKey(const char[] key);
-static cell_t Native_OrdMap_GetEntryTypeByKey(IPluginContext *pContext, const cell_t *params)
+/// int InsertStrings(const char[][] keys, const char[][] strs, int n);
+static cell_t Native_OrdMap_InsertStrings(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL ) {
 		return 0;
 	} else if( params[4] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative length (%d) as buffer length for OrdMap", params[4]);
+		pContext->ThrowNativeError("cannot insert a negative amount (%d) of OrdMap entries", params[4]);
+		return 0;
+	} else if( ( size_t )params[4] > map_max_entries() - map->len ) {
+		pContext->ThrowNativeError("cannot insert %d entries", params[4]);
 		return 0;
 	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
+	cell_t *rows = GetCellAddr(pContext, params[2]);
+	cell_t *str_rows = GetCellAddr(pContext, params[3]);
+	if( rows==NULL || str_rows==NULL )
 		return 0;
 	
-	MapEntry *entry = map_key_get(map, key);
-	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for key '%s'", key);
+	const size_t n = ( size_t )params[4];
+	if( !map_prepare_insert(map, n) ) {
+		pContext->ThrowNativeError("unable to make room for %d OrdMap entries", params[4]);
 		return 0;
 	}
-	return( cell_t )entry->tag;
+	
+	cell_t count = 0;
+	for( size_t i=0; i<n; i++ ) {
+		char *key = GetParamString(pContext, ArrayRow(params[2], rows, i));
+		char *str = GetParamString(pContext, ArrayRow(params[3], str_rows, i));
+		if( key==NULL || str==NULL )
+			return count;
+		
+		bool inserted = false;
+		MapEntry *entry = map_key_entry(map, key, &inserted);
+		if( entry==nullptr )
+			return count;
+		else if( !inserted )
+			continue;
+		else if( map_set_array(map, entry, StrEntry, ( const uint8_t* )str, sizeof(char), 0) )
+			count++;
+		else
+			map_entry_rm(map, entry);
+	}
+	return count;
 }
 
-/// MapEntryType GetEntryTypeByIndex(int index);
-static cell_t Native_OrdMap_GetEntryTypeByIndex(IPluginContext *pContext, const cell_t *params)
+/// int GetCellsByIndexRange(int start, int count, any[] items);
+static cell_t Native_OrdMap_GetCellsByIndexRange(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL ) {
 		return 0;
-	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to get entry type from OrdMap", params[2]);
+	} else if( params[2] < 0 || params[3] < 0 ) {
+		pContext->ThrowNativeError("cannot use negative start (%d) or count (%d) for an OrdMap index range", params[2], params[3]);
 		return 0;
 	}
-	const size_t index = ( size_t )params[2];
-	MapEntry *entry = map_idx_get(map, index);
-	if( entry==nullptr ) {
-		pContext->ThrowNativeError("Unable to retrieve OrdMap entry for index '%zu'", index);
+	
+	cell_t *items = GetCellAddr(pContext, params[4]);
+	if( items==NULL )
 		return 0;
+	
+	const size_t start = ( size_t )params[2];
+	size_t count = ( size_t )params[3];
+	MapEntry *const *window = map_idx_range(map, start, &count);
+	/// checked up front so an error leaves `items` untouched.
+	for( size_t i=0; i<count; i++ ) {
+		if( window[i] != nullptr && window[i]->tag != CellEntry ) {
+			pContext->ThrowNativeError("OrdMap entry index '%zu' is not a cell type", start + i);
+			return 0;
+		}
+	}
+	
+	/// holes of stable-index maps are skipped.
+	cell_t copied = 0;
+	for( size_t i=0; i<count; i++ ) {
+		if( window[i] != nullptr )
+			items[copied++] = window[i]->data.i;
 	}
-	return( cell_t )entry->tag;
+	return copied;
 }
 
-/// bool RemoveByKey(const char[] key);
-static cell_t Native_OrdMap_RemoveByKey(IPluginContext *pContext, const cell_t *params)
+/// int GetKeysByIndexRange(int start, int count, char[][] keys, int maxlength);
+static cell_t Native_OrdMap_GetKeysByIndexRange(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL ) {
+		return 0;
+	} else if( params[2] < 0 || params[3] < 0 ) {
+		pContext->ThrowNativeError("cannot use negative start (%d) or count (%d) for an OrdMap index range", params[2], params[3]);
+		return 0;
+	} else if( params[5] <= 0 ) {
+		pContext->ThrowNativeError("cannot use non-positive length (%d) as buffer length for OrdMap", params[5]);
 		return 0;
 	}
 	
-	char *key = GetParamString(pContext, params[2]);
-	if( key==NULL )
+	cell_t *rows = GetCellAddr(pContext, params[4]);
+	if( rows==NULL )
 		return 0;
 	
-	return ( cell_t )map_key_rm(map, key);
+	const size_t start = ( size_t )params[2];
+	size_t count = ( size_t )params[3];
+	MapEntry *const *window = map_idx_range(map, start, &count);
+	/// checked up front so an error leaves `keys` untouched.
+	for( size_t i=0; i<count; i++ ) {
+		if( window[i] != nullptr && window[i]->key.type != StrKey && window[i]->key.type != InternKey ) {
+			pContext->ThrowNativeError("OrdMap entry index '%zu' does not have a string key", start + i);
+			return 0;
+		}
+	}
+	
+	/// holes of stable-index maps are skipped, same as `GetCellsByIndexRange` does.
+	cell_t copied = 0;
+	for( size_t i=0; i<count; i++ ) {
+		if( window[i] != nullptr )
+			pContext->StringToLocal(ArrayRow(params[4], rows, copied++), ( size_t )params[5], map_key_cstr(&window[i]->key));
+	}
+	return copied;
 }
 
-/// bool RemoveByIndex(int index);
-static cell_t Native_OrdMap_RemoveByIndex(IPluginContext *pContext, const cell_t *params)
+/// int *InsertCellEx(key, any item);
+template< typename Mode >
+static cell_t Native_InsertCellEx(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
+		return 0;
 	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	bool inserted = false;
+	MapEntry *entry = Mode::Entry(map, key, &inserted);
+	if( entry==nullptr || !inserted )
 		return 0;
-	} else if( params[2] < 0 ) {
-		pContext->ThrowNativeError("cannot use negative index (%d) to remove from OrdMap", params[2]);
+	
+	/// a 0 id has to mean the key was already there, so a failed insert takes its key back out.
+	const uint32_t id = map_entry_id(map, entry);
+	if( id==0 || !map_assign(map, entry, CellEntry, entry_data_from_int(params[3])) ) {
+		map_entry_rm(map, entry);
+		ThrowEntryError< Mode >(pContext, key, "unable to insert OrdMap entry for %s");
 		return 0;
 	}
-	const size_t n = ( size_t )params[2];
-	return ( cell_t )map_idx_rm(map, n);
+	return ( cell_t )id;
+}
+
+/// int GetIdBy*(key);
+template< typename Mode >
+static cell_t Native_GetId(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	NativeKey key;
+	if( map==NULL || !Mode::Read(pContext, map, params[2], &key) )
+		return 0;
+	
+	MapEntry *entry = Mode::Find(map, key);
+	if( entry==nullptr )
+		return 0;
+	
+	return ( cell_t )map_entry_id(map, entry);
+}
+
+/// OrdMap Clone();
+static cell_t Native_OrdMap_Clone(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL )
+		return BAD_HANDLE;
+	
+	CMap *copy = map_clone(map);
+	if( copy==nullptr )
+		return BAD_HANDLE;
+	
+	const Handle_t hndl = g_pHandleSys->CreateHandle(g_OrdMapType, copy, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+	if( hndl==BAD_HANDLE )
+		map_free(&copy);
+	else
+		copy->user = hndl;
+	return hndl;
 }
 
 /// void Clear();
 static cell_t Native_OrdMap_Clear(IPluginContext *pContext, const cell_t *params)
 {
-	Handle_t hndl = static_cast< Handle_t >(params[1]);
-	HandleSecurity sec = MakeHandleSec();
-	
-	CMap *map = NULL;
-	HandleError err;
-	if( (err = g_pHandleSys->ReadHandle(hndl, g_OrdMapType, &sec, ( void** )&map)) != HandleError_None ) {
-		pContext->ThrowNativeError("Invalid OrdMap Handle %x (error %d)", hndl, err);
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL )
 		return 0;
-	}
 	map_clear(map);
 	return 1;
 }
 
+/// void Compact();
+static cell_t Native_OrdMap_Compact(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL )
+		return 0;
+	map_compact(map);
+	return 1;
+}
+
+/// bool TrimToSize();
+static cell_t Native_OrdMap_TrimToSize(IPluginContext *pContext, const cell_t *params)
+{
+	CMap *map = GetMap(pContext, params);
+	if( map==NULL )
+		return 0;
+	return ( cell_t )map_trim(map);
+}
+
 sp_nativeinfo_t g_Natives[] = {
-	{"OrdMap.OrdMap",              Native_OrdMap_Ctor},
-	{"OrdMap.Len.get",             Native_OrdMap_Len},
-	
-	{"OrdMap.HasKey",              Native_OrdMap_HasKey},
-	
-	{"OrdMap.InsertCell",          Native_OrdMap_InsertCell},
-	{"OrdMap.InsertArray",         Native_OrdMap_InsertArray},
-	{"OrdMap.InsertString",        Native_OrdMap_InsertString},
-	
-	{"OrdMap.GetCellByKey",        Native_OrdMap_GetCellByKey},
-	{"OrdMap.GetCellByIndex",      Native_OrdMap_GetCellByIndex},
-	
-	{"OrdMap.GetArrayLenByKey",    Native_OrdMap_GetArrayLenByKey},
-	{"OrdMap.GetArrayLenByIndex",  Native_OrdMap_GetArrayLenByIndex},
-	{"OrdMap.GetStringLenByKey",   Native_OrdMap_GetStringLenByKey},
-	{"OrdMap.GetStringLenByIndex", Native_OrdMap_GetStringLenByIndex},
-	
-	{"OrdMap.GetArrayByKey",       Native_OrdMap_GetArrayByKey},
-	{"OrdMap.GetArrayByIndex",     Native_OrdMap_GetArrayByIndex},
-	{"OrdMap.GetStringByKey",      Native_OrdMap_GetStringByKey},
-	{"OrdMap.GetStringByIndex",    Native_OrdMap_GetStringByIndex},
-	
-	{"OrdMap.SetCellByKey",        Native_OrdMap_SetCellByKey},
-	{"OrdMap.SetCellByIndex",      Native_OrdMap_SetCellByIndex},
-	
-	{"OrdMap.SetArrayByKey",       Native_OrdMap_SetArrayByKey},
-	{"OrdMap.SetArrayByIndex",     Native_OrdMap_SetArrayByIndex},
-	{"OrdMap.SetStringByKey",      Native_OrdMap_SetStringByKey},
-	{"OrdMap.SetStringByIndex",    Native_OrdMap_SetStringByIndex},
-	
-	{"OrdMap.GetEntryTypeByKey",   Native_OrdMap_GetEntryTypeByKey},
-	{"OrdMap.GetEntryTypeByIndex", Native_OrdMap_GetEntryTypeByIndex},
-	
-	{"OrdMap.RemoveByKey",         Native_OrdMap_RemoveByKey},
-	{"OrdMap.RemoveByIndex",       Native_OrdMap_RemoveByIndex},
-	
-	{"OrdMap.Clear",               Native_OrdMap_Clear},
-	
-	{NULL,                         NULL}
-};
\ No newline at end of file
+	{"OrdMapKey.OrdMapKey",                Native_OrdMapKey_Ctor},
+	{"OrdMap.OrdMap",                      Native_OrdMap_Ctor},
+	{"OrdMap.Len.get",                     Native_OrdMap_Len},
+	{"OrdMap.Count.get",                   Native_OrdMap_Count},
+	{"OrdMap.Capacity.get",                Native_OrdMap_Capacity},
+	{"OrdMap.Reserve",                     Native_OrdMap_Reserve},
+	
+	{"OrdMap.HasKey",                      Native_Has< StrKeyMode >},
+	{"OrdMap.HasCellKey",                  Native_Has< CellKeyMode >},
+	{"OrdMap.HasInt64Key",                 Native_Has< Int64KeyMode >},
+	{"OrdMap.HasToken",                    Native_Has< TokenMode >},
+	
+	{"OrdMap.InsertCell",                  Native_Insert< StrKeyMode, CellValue >},
+	{"OrdMap.CellKeyInsertCell",           Native_Insert< CellKeyMode, CellValue >},
+	{"OrdMap.Int64KeyInsertCell",          Native_Insert< Int64KeyMode, CellValue >},
+	{"OrdMap.TokenInsertCell",             Native_Insert< TokenMode, CellValue >},
+	{"OrdMap.InsertArray",                 Native_Insert< StrKeyMode, ArrayValue >},
+	{"OrdMap.CellKeyInsertArray",          Native_Insert< CellKeyMode, ArrayValue >},
+	{"OrdMap.Int64KeyInsertArray",         Native_Insert< Int64KeyMode, ArrayValue >},
+	{"OrdMap.TokenInsertArray",            Native_Insert< TokenMode, ArrayValue >},
+	{"OrdMap.InsertString",                Native_Insert< StrKeyMode, StrValue >},
+	{"OrdMap.CellKeyInsertString",         Native_Insert< CellKeyMode, StrValue >},
+	{"OrdMap.Int64KeyInsertString",        Native_Insert< Int64KeyMode, StrValue >},
+	{"OrdMap.TokenInsertString",           Native_Insert< TokenMode, StrValue >},
+	
+	{"OrdMap.InsertCells",                 Native_OrdMap_InsertCells},
+	{"OrdMap.InsertArrays",                Native_OrdMap_InsertArrays},
+	{"OrdMap.InsertStrings",               Native_OrdMap_InsertStrings},
+	
+	{"OrdMap.GetCellByKey",                Native_Get< StrKeyMode, CellValue >},
+	{"OrdMap.GetCellByCellKey",            Native_Get< CellKeyMode, CellValue >},
+	{"OrdMap.GetCellByInt64Key",           Native_Get< Int64KeyMode, CellValue >},
+	{"OrdMap.GetCellByToken",              Native_Get< TokenMode, CellValue >},
+	{"OrdMap.GetCellByIndex",              Native_Get< IndexMode, CellValue >},
+	
+	{"OrdMap.GetCellsByIndexRange",        Native_OrdMap_GetCellsByIndexRange},
+	{"OrdMap.GetKeysByIndexRange",         Native_OrdMap_GetKeysByIndexRange},
+	
+	{"OrdMap.GetArrayLenByKey",            Native_Len< StrKeyMode, ArrayValue >},
+	{"OrdMap.GetArrayLenByCellKey",        Native_Len< CellKeyMode, ArrayValue >},
+	{"OrdMap.GetArrayLenByInt64Key",       Native_Len< Int64KeyMode, ArrayValue >},
+	{"OrdMap.GetArrayLenByToken",          Native_Len< TokenMode, ArrayValue >},
+	{"OrdMap.GetArrayLenByIndex",          Native_Len< IndexMode, ArrayValue >},
+	{"OrdMap.GetStringLenByKey",           Native_Len< StrKeyMode, StrValue >},
+	{"OrdMap.GetStringLenByCellKey",       Native_Len< CellKeyMode, StrValue >},
+	{"OrdMap.GetStringLenByInt64Key",      Native_Len< Int64KeyMode, StrValue >},
+	{"OrdMap.GetStringLenByToken",         Native_Len< TokenMode, StrValue >},
+	{"OrdMap.GetStringLenByIndex",         Native_Len< IndexMode, StrValue >},
+	
+	{"OrdMap.GetArrayByKey",               Native_Get< StrKeyMode, ArrayValue >},
+	{"OrdMap.GetArrayByCellKey",           Native_Get< CellKeyMode, ArrayValue >},
+	{"OrdMap.GetArrayByInt64Key",          Native_Get< Int64KeyMode, ArrayValue >},
+	{"OrdMap.GetArrayByToken",             Native_Get< TokenMode, ArrayValue >},
+	{"OrdMap.GetArrayByIndex",             Native_Get< IndexMode, ArrayValue >},
+	{"OrdMap.GetStringByKey",              Native_Get< StrKeyMode, StrValue >},
+	{"OrdMap.GetStringByCellKey",          Native_Get< CellKeyMode, StrValue >},
+	{"OrdMap.GetStringByInt64Key",         Native_Get< Int64KeyMode, StrValue >},
+	{"OrdMap.GetStringByToken",            Native_Get< TokenMode, StrValue >},
+	{"OrdMap.GetStringByIndex",            Native_Get< IndexMode, StrValue >},
+	
+	{"OrdMap.SetCellByKey",                Native_Set< StrKeyMode, CellValue >},
+	{"OrdMap.SetCellByCellKey",            Native_Set< CellKeyMode, CellValue >},
+	{"OrdMap.SetCellByInt64Key",           Native_Set< Int64KeyMode, CellValue >},
+	{"OrdMap.SetCellByToken",              Native_Set< TokenMode, CellValue >},
+	{"OrdMap.SetCellByIndex",              Native_Set< IndexMode, CellValue >},
+	
+	{"OrdMap.SetArrayByKey",               Native_Set< StrKeyMode, ArrayValue >},
+	{"OrdMap.SetArrayByCellKey",           Native_Set< CellKeyMode, ArrayValue >},
+	{"OrdMap.SetArrayByInt64Key",          Native_Set< Int64KeyMode, ArrayValue >},
+	{"OrdMap.SetArrayByToken",             Native_Set< TokenMode, ArrayValue >},
+	{"OrdMap.SetArrayByIndex",             Native_Set< IndexMode, ArrayValue >},
+	
+	{"OrdMap.SetStringByKey",              Native_Set< StrKeyMode, StrValue >},
+	{"OrdMap.SetStringByCellKey",          Native_Set< CellKeyMode, StrValue >},
+	{"OrdMap.SetStringByInt64Key",         Native_Set< Int64KeyMode, StrValue >},
+	{"OrdMap.SetStringByToken",            Native_Set< TokenMode, StrValue >},
+	{"OrdMap.SetStringByIndex",            Native_Set< IndexMode, StrValue >},
+	
+	{"OrdMap.AddCellByKey",                Native_UpdateCell< StrKeyMode, AddOp >},
+	{"OrdMap.AddCellByCellKey",            Native_UpdateCell< CellKeyMode, AddOp >},
+	{"OrdMap.AddCellByInt64Key",           Native_UpdateCell< Int64KeyMode, AddOp >},
+	{"OrdMap.AddCellByToken",              Native_UpdateCell< TokenMode, AddOp >},
+	{"OrdMap.AddCellByIndex",              Native_UpdateCell< IndexMode, AddOp >},
+	{"OrdMap.IncrementCellByKey",          Native_UpdateCell< StrKeyMode, IncrementOp >},
+	{"OrdMap.IncrementCellByCellKey",      Native_UpdateCell< CellKeyMode, IncrementOp >},
+	{"OrdMap.IncrementCellByInt64Key",     Native_UpdateCell< Int64KeyMode, IncrementOp >},
+	{"OrdMap.IncrementCellByToken",        Native_UpdateCell< TokenMode, IncrementOp >},
+	{"OrdMap.IncrementCellByIndex",        Native_UpdateCell< IndexMode, IncrementOp >},
+	{"OrdMap.MinCellByKey",                Native_UpdateCell< StrKeyMode, MinOp >},
+	{"OrdMap.MinCellByCellKey",            Native_UpdateCell< CellKeyMode, MinOp >},
+	{"OrdMap.MinCellByInt64Key",           Native_UpdateCell< Int64KeyMode, MinOp >},
+	{"OrdMap.MinCellByToken",              Native_UpdateCell< TokenMode, MinOp >},
+	{"OrdMap.MinCellByIndex",              Native_UpdateCell< IndexMode, MinOp >},
+	{"OrdMap.MaxCellByKey",                Native_UpdateCell< StrKeyMode, MaxOp >},
+	{"OrdMap.MaxCellByCellKey",            Native_UpdateCell< CellKeyMode, MaxOp >},
+	{"OrdMap.MaxCellByInt64Key",           Native_UpdateCell< Int64KeyMode, MaxOp >},
+	{"OrdMap.MaxCellByToken",              Native_UpdateCell< TokenMode, MaxOp >},
+	{"OrdMap.MaxCellByIndex",              Native_UpdateCell< IndexMode, MaxOp >},
+	{"OrdMap.CompareAndSetCellByKey",      Native_CompareAndSetCell< StrKeyMode >},
+	{"OrdMap.CompareAndSetCellByCellKey",  Native_CompareAndSetCell< CellKeyMode >},
+	{"OrdMap.CompareAndSetCellByInt64Key", Native_CompareAndSetCell< Int64KeyMode >},
+	{"OrdMap.CompareAndSetCellByToken",    Native_CompareAndSetCell< TokenMode >},
+	{"OrdMap.CompareAndSetCellByIndex",    Native_CompareAndSetCell< IndexMode >},
+	
+	{"OrdMap.GetArrayElementByKey",        Native_GetArrayElement< StrKeyMode >},
+	{"OrdMap.GetArrayElementByCellKey",    Native_GetArrayElement< CellKeyMode >},
+	{"OrdMap.GetArrayElementByInt64Key",   Native_GetArrayElement< Int64KeyMode >},
+	{"OrdMap.GetArrayElementByToken",      Native_GetArrayElement< TokenMode >},
+	{"OrdMap.GetArrayElementByIndex",      Native_GetArrayElement< IndexMode >},
+	{"OrdMap.SetArrayElementByKey",        Native_SetArrayElement< StrKeyMode >},
+	{"OrdMap.SetArrayElementByCellKey",    Native_SetArrayElement< CellKeyMode >},
+	{"OrdMap.SetArrayElementByInt64Key",   Native_SetArrayElement< Int64KeyMode >},
+	{"OrdMap.SetArrayElementByToken",      Native_SetArrayElement< TokenMode >},
+	{"OrdMap.SetArrayElementByIndex",      Native_SetArrayElement< IndexMode >},
+	
+	{"OrdMap.GetArraySliceByKey",          Native_GetArraySlice< StrKeyMode >},
+	{"OrdMap.GetArraySliceByCellKey",      Native_GetArraySlice< CellKeyMode >},
+	{"OrdMap.GetArraySliceByInt64Key",     Native_GetArraySlice< Int64KeyMode >},
+	{"OrdMap.GetArraySliceByToken",        Native_GetArraySlice< TokenMode >},
+	{"OrdMap.GetArraySliceByIndex",        Native_GetArraySlice< IndexMode >},
+	{"OrdMap.SetArraySliceByKey",          Native_SetArraySlice< StrKeyMode >},
+	{"OrdMap.SetArraySliceByCellKey",      Native_SetArraySlice< CellKeyMode >},
+	{"OrdMap.SetArraySliceByInt64Key",     Native_SetArraySlice< Int64KeyMode >},
+	{"OrdMap.SetArraySliceByToken",        Native_SetArraySlice< TokenMode >},
+	{"OrdMap.SetArraySliceByIndex",        Native_SetArraySlice< IndexMode >},
+	
+	{"OrdMap.PushArrayByKey",              Native_PushArray< StrKeyMode >},
+	{"OrdMap.PushArrayByCellKey",          Native_PushArray< CellKeyMode >},
+	{"OrdMap.PushArrayByInt64Key",         Native_PushArray< Int64KeyMode >},
+	{"OrdMap.PushArrayByToken",            Native_PushArray< TokenMode >},
+	{"OrdMap.PushArrayByIndex",            Native_PushArray< IndexMode >},
+	{"OrdMap.PopArrayByKey",               Native_PopArray< StrKeyMode >},
+	{"OrdMap.PopArrayByCellKey",           Native_PopArray< CellKeyMode >},
+	{"OrdMap.PopArrayByInt64Key",          Native_PopArray< Int64KeyMode >},
+	{"OrdMap.PopArrayByToken",             Native_PopArray< TokenMode >},
+	{"OrdMap.PopArrayByIndex",             Native_PopArray< IndexMode >},
+	{"OrdMap.AppendStringByKey",           Native_AppendString< StrKeyMode >},
+	{"OrdMap.AppendStringByCellKey",       Native_AppendString< CellKeyMode >},
+	{"OrdMap.AppendStringByInt64Key",      Native_AppendString< Int64KeyMode >},
+	{"OrdMap.AppendStringByToken",         Native_AppendString< TokenMode >},
+	{"OrdMap.AppendStringByIndex",         Native_AppendString< IndexMode >},
+	
+	{"OrdMap.GetEntryTypeByKey",           Native_EntryType< StrKeyMode >},
+	{"OrdMap.GetEntryTypeByCellKey",       Native_EntryType< CellKeyMode >},
+	{"OrdMap.GetEntryTypeByInt64Key",      Native_EntryType< Int64KeyMode >},
+	{"OrdMap.GetEntryTypeByToken",         Native_EntryType< TokenMode >},
+	{"OrdMap.GetEntryTypeByIndex",         Native_EntryType< IndexMode >},
+	
+	{"OrdMap.RemoveByKey",                 Native_Remove< StrKeyMode >},
+	{"OrdMap.RemoveByCellKey",             Native_Remove< CellKeyMode >},
+	{"OrdMap.RemoveByInt64Key",            Native_Remove< Int64KeyMode >},
+	{"OrdMap.RemoveByToken",               Native_Remove< TokenMode >},
+	{"OrdMap.RemoveByIndex",               Native_Remove< IndexMode >},
+	
+	{"OrdMap.InsertCellEx",                Native_InsertCellEx< StrKeyMode >},
+	{"OrdMap.CellKeyInsertCellEx",         Native_InsertCellEx< CellKeyMode >},
+	{"OrdMap.Int64KeyInsertCellEx",        Native_InsertCellEx< Int64KeyMode >},
+	{"OrdMap.TokenInsertCellEx",           Native_InsertCellEx< TokenMode >},
+	{"OrdMap.GetIdByKey",                  Native_GetId< StrKeyMode >},
+	{"OrdMap.GetIdByCellKey",              Native_GetId< CellKeyMode >},
+	{"OrdMap.GetIdByInt64Key",             Native_GetId< Int64KeyMode >},
+	{"OrdMap.GetIdByToken",                Native_GetId< TokenMode >},
+	{"OrdMap.GetCellById",                 Native_Get< IdMode, CellValue >},
+	{"OrdMap.SetCellById",                 Native_Set< IdMode, CellValue >},
+	{"OrdMap.RemoveById",                  Native_Remove< IdMode >},
+	
+	{"OrdMap.Clone",                       Native_OrdMap_Clone},
+	{"OrdMap.Clear",                       Native_OrdMap_Clear},
+	{"OrdMap.Compact",                     Native_OrdMap_Compact},
+	{"OrdMap.TrimToSize",                  Native_OrdMap_TrimToSize},
+	
+	{NULL,                                 NULL}
+};
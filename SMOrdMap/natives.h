@@ -3,4 +3,7 @@
 
 #include "extension.h"
 
+/// drops `map` from the handle cache, must be called before the map is freed.
+void ForgetCachedMap(const CMap *map);
+
 #endif /// NATIVES_INCLUDED
\ No newline at end of file
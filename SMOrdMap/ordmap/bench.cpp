@@ -0,0 +1,209 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+
+typedef int32_t cell_t; /// normally comes from the SourcePawn headers.
+#include "ordmap.h"
+
+enum { BENCH_KEYS = 200000 };
+
+static char g_keys[BENCH_KEYS][32];
+
+struct Timer {
+	std::chrono::steady_clock::time_point start;
+	Timer() : start(std::chrono::steady_clock::now()) {}
+	
+	double ns_per(const size_t ops) const {
+		const std::chrono::duration< double, std::nano > d = std::chrono::steady_clock::now() - start;
+		return d.count() / ops;
+	}
+};
+
+static void report(const char *name, const double ns) {
+	printf("%-24s %8.1f ns/op\n", name, ns);
+}
+
+/// slowest insert that grew the table (the game-frame hitch) and the 99.9th percentile of all inserts.
+/// a raw max isn't used since scheduler ticks swamp it.
+static void worst_insert(const char *name, const uint32_t flags) {
+	static double lat[BENCH_KEYS];
+	CMap *map = new_map(8, flags);
+	double worst_grow = 0.0;
+	for( size_t i=0; i<BENCH_KEYS; i++ ) {
+		const size_t cap = map->cap;
+		Timer t;
+		map_insert(map, g_keys[i], CellEntry, entry_data_from_int(( cell_t )i));
+		lat[i] = t.ns_per(1);
+		if( cap != map->cap && lat[i] > worst_grow )
+			worst_grow = lat[i];
+	}
+	std::sort(lat, lat + BENCH_KEYS);
+	printf("%-24s %8.1f us growing, %6.1f us p99.9\n", name, worst_grow / 1000.0, lat[BENCH_KEYS - BENCH_KEYS / 1000] / 1000.0);
+	map_free(&map);
+}
+
+/// resident set size in KB, only tracked on linux.
+static long rss_kb() {
+#ifdef __linux__
+	long pages = 0, resident = 0;
+	FILE *f = fopen("/proc/self/statm", "r");
+	if( f != NULL ) {
+		if( fscanf(f, "%ld %ld", &pages, &resident) != 2 )
+			resident = 0;
+		fclose(f);
+	}
+	return resident * 4;
+#else
+	return 0;
+#endif
+}
+
+/// players joining and leaving for many rounds, memory should level off instead of creeping.
+static void churn() {
+	enum { PLAYERS = 4096, ROUNDS = 200 };
+	CMap *map = new_map();
+	for( size_t i=0; i<PLAYERS; i++ )
+		map_insert(map, g_keys[i], CellEntry, entry_data_from_int(( cell_t )i));
+	
+	Timer t;
+	size_t next = PLAYERS;
+	for( size_t round=0; round<ROUNDS; round++ ) {
+		for( size_t i=0; i<PLAYERS / 4; i++, next++ ) {
+			map_key_rm(map, g_keys[(next - PLAYERS) % BENCH_KEYS]);
+			map_insert(map, g_keys[next % BENCH_KEYS], CellEntry, entry_data_from_int(( cell_t )i));
+		}
+		if( round==ROUNDS / 10 || round==ROUNDS - 1 )
+			printf("churn round %-12zu %8ld KB rss\n", round + 1, rss_kb());
+	}
+	report("churn (remove+insert)", t.ns_per(ROUNDS * (PLAYERS / 4)));
+	map_free(&map);
+}
+
+/// many per-player maps sharing the same field names, with and without a shared key pool.
+/// `tokens` looks the fields up by `map_key_pool_token` tokens instead of by string.
+static void per_player(const char *name, const uint32_t flags, const bool tokens = false) {
+	enum { PLAYERS = 256, FIELDS = 32, ROUNDS = 50 };
+	static char fields[FIELDS][40];
+	for( size_t i=0; i<FIELDS; i++ )
+		snprintf(fields[i], sizeof fields[i], "player_stat_field_number_%zu", i);
+	
+	MapKeyPool keys;
+	map_key_pool_init(&keys);
+	MapInterned *toks[FIELDS];
+	for( size_t f=0; f<FIELDS; f++ ) {
+		const MapKeyView v = map_str_key(fields[f]);
+		toks[f] = map_key_pool_from_token(&keys, map_key_pool_token(&keys, &v));
+	}
+	static CMap *maps[PLAYERS];
+	Timer t;
+	for( size_t i=0; i<PLAYERS; i++ ) {
+		maps[i] = new_map(FIELDS, flags, &keys);
+		for( size_t f=0; f<FIELDS; f++ )
+			map_insert(maps[i], fields[f], CellEntry, entry_data_from_int(( cell_t )f));
+	}
+	uint32_t sum = 0; /// unsigned so the wraparound is defined.
+	for( size_t r=0; r<ROUNDS; r++ )
+		for( size_t i=0; i<PLAYERS; i++ )
+			for( size_t f=0; f<FIELDS; f++ )
+				if( tokens ) {
+					const MapKeyView v = map_token_key(maps[i], toks[f]);
+					sum += ( uint32_t )map_view_get(maps[i], &v)->data.i;
+				} else {
+					sum += ( uint32_t )map_key_get(maps[i], fields[f])->data.i;
+				}
+	report(name, t.ns_per(PLAYERS * FIELDS * (ROUNDS + 1)));
+	if( sum==42 )
+		puts("");
+	for( size_t i=0; i<PLAYERS; i++ )
+		map_free(&maps[i]);
+	map_key_pool_clear(&keys);
+}
+
+int main() {
+	for( size_t i=0; i<BENCH_KEYS; i++ )
+		snprintf(g_keys[i], sizeof g_keys[i], "STEAM_0:1:%zu", i * 7919);
+	
+	CMap *map = new_map();
+	{
+		Timer t;
+		for( size_t i=0; i<BENCH_KEYS; i++ )
+			map_insert(map, g_keys[i], CellEntry, entry_data_from_int(( cell_t )i));
+		report("insert", t.ns_per(BENCH_KEYS));
+	}
+	{
+		Timer t;
+		uint32_t sum = 0;
+		for( size_t i=0; i<BENCH_KEYS; i++ )
+			sum += ( uint32_t )map_key_get(map, g_keys[i])->data.i;
+		report("get (hit)", t.ns_per(BENCH_KEYS));
+		if( sum==42 )
+			puts("");
+	}
+	{
+		Timer t;
+		for( size_t i=0; i<BENCH_KEYS; i++ )
+			map_key_set(map, g_keys[i], CellEntry, entry_data_from_int(( cell_t )i + 1));
+		report("set (existing)", t.ns_per(BENCH_KEYS));
+	}
+	{
+		static uint32_t ids[BENCH_KEYS];
+		for( size_t i=0; i<BENCH_KEYS; i++ )
+			ids[i] = map_entry_id(map, map_key_get(map, g_keys[i]));
+		
+		Timer t;
+		uint32_t sum = 0;
+		for( size_t i=0; i<BENCH_KEYS; i++ )
+			sum += ( uint32_t )map_id_get(map, ids[i])->data.i;
+		report("get by id", t.ns_per(BENCH_KEYS));
+		if( sum==42 )
+			puts("");
+	}
+	{
+		Timer t;
+		for( size_t i=0; i<BENCH_KEYS; i++ )
+			map_key_rm(map, g_keys[i]);
+		report("remove by key", t.ns_per(BENCH_KEYS));
+	}
+	{
+		Timer t;
+		for( size_t i=0; i<BENCH_KEYS; i++ )
+			map_key_set(map, g_keys[i], CellEntry, entry_data_from_int(( cell_t )i));
+		report("set (new key)", t.ns_per(BENCH_KEYS));
+	}
+	map_free(&map);
+	
+	{
+		/// a config load, the whole batch goes in after one presize.
+		map = new_map();
+		Timer t;
+		map_prepare_insert(map, BENCH_KEYS);
+		for( size_t i=0; i<BENCH_KEYS; i++ )
+			map_insert(map, g_keys[i], CellEntry, entry_data_from_int(( cell_t )i));
+		report("insert (presized batch)", t.ns_per(BENCH_KEYS));
+		
+		/// duplicating it the way a plugin would, index by index, against one clone.
+		Timer r;
+		struct CMap *copy = new_map();
+		for( size_t i=0; i<map_span(map); i++ ) {
+			const struct MapEntry *entry = map_idx_get(map, i);
+			map_insert(copy, map_key_cstr(&entry->key), entry->tag, entry->data);
+		}
+		report("copy (re-insert)", r.ns_per(BENCH_KEYS));
+		map_free(&copy);
+		
+		Timer c;
+		copy = map_clone(map);
+		report("copy (clone)", c.ns_per(BENCH_KEYS));
+		map_free(&copy);
+		map_free(&map);
+	}
+	
+	worst_insert("worst insert (full)", MapDefault);
+	worst_insert("worst insert (incr)", MapIncrementalRehash);
+	churn();
+	per_player("per-player maps", MapDefault);
+	per_player("per-player (interned)", MapInternKeys);
+	per_player("per-player (tokens)", MapInternKeys, true);
+}
@@ -15,19 +15,165 @@ extern "C" {
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
 
 #include "carray.h"
-#include "cstr.h"
 
 #define CMAP_API    static
 
 
-static size_t str_hash(const char *const key) {
-	size_t h = 0;
-	for( size_t i=0; key[i] != 0; i++ ) {
-		h = (h<<6) ^ (h>>26) ^ key[i];
+/// wyhash (final version, public domain by Wang Yi), reads the key a word at a time.
+/// 64x64 -> 128-bit multiply, `a` gets the low half and `b` the high half.
+static void _wymum(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+	const __uint128_t r = ( __uint128_t )*a * *b;
+	*a = ( uint64_t )r; *b = ( uint64_t )(r >> 64);
+#else
+	/// 32-bit builds (srcds is usually x86) don't have a native 128-bit product.
+	const uint64_t ha = *a >> 32, hb = *b >> 32, la = ( uint32_t )*a, lb = ( uint32_t )*b;
+	const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+	uint64_t lo = t + (rm1 << 32), hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl);
+	hi += (lo < t);
+	*a = lo; *b = hi;
+#endif
+}
+
+static uint64_t _wymix(uint64_t a, uint64_t b) {
+	_wymum(&a, &b);
+	return a ^ b;
+}
+
+static uint64_t _wyr8(const uint8_t *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static uint64_t _wyr4(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static uint64_t _wyr3(const uint8_t *p, const size_t k) {
+	return ((( uint64_t )p[0]) << 16) | ((( uint64_t )p[k >> 1]) << 8) | p[k - 1];
+}
+
+static size_t str_hash(const char *const key, const size_t len, uint64_t seed) {
+	static const uint64_t s0 = 0xa0761d6478bd642full, s1 = 0xe7037ed1a0b428dbull, s2 = 0x8ebc6af09c88c6e3ull, s3 = 0x589965cc75374cc3ull;
+	const uint8_t *p = ( const uint8_t* )key;
+	uint64_t a, b;
+	seed ^= _wymix(seed ^ s0, s1);
+	if( len <= 16 ) {
+		if( len >= 4 ) {
+			a = (_wyr4(p) << 32) | _wyr4(p + ((len >> 3) << 2));
+			b = (_wyr4(p + len - 4) << 32) | _wyr4(p + len - 4 - ((len >> 3) << 2));
+		} else if( len > 0 ) {
+			a = _wyr3(p, len);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = len;
+		if( i > 48 ) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = _wymix(_wyr8(p)      ^ s1, _wyr8(p + 8)  ^ seed);
+				see1 = _wymix(_wyr8(p + 16) ^ s2, _wyr8(p + 24) ^ see1);
+				see2 = _wymix(_wyr8(p + 32) ^ s3, _wyr8(p + 40) ^ see2);
+				p += 48; i -= 48;
+			} while( i > 48 );
+			seed ^= see1 ^ see2;
+		}
+		while( i > 16 ) {
+			seed = _wymix(_wyr8(p) ^ s1, _wyr8(p + 8) ^ seed);
+			p += 16; i -= 16;
+		}
+		a = _wyr8(p + i - 16);
+		b = _wyr8(p + i - 8);
+	}
+	a ^= s1; b ^= seed;
+	_wymum(&a, &b);
+	return ( size_t )_wymix(a ^ s0 ^ len, b ^ s1);
+}
+
+/// per-map seed so colliding keys can't be precomputed offline (HashDoS).
+/// not cryptographic, but ASLR'd addresses plus time aren't visible to players.
+static uint64_t _make_hash_seed(const void *const salt) {
+	static uint64_t counter = 0;
+	const uint64_t x = ( uint64_t )( uintptr_t )salt ^ (( uint64_t )time(NULL) << 20) ^ ( uint64_t )clock();
+	return _wymix(x ^ 0x2d358dccaa6c78a5ull, ++counter ^ 0x8bb84b93962eacc9ull);
+}
+
+
+enum { MAP_ARENA_CHUNK = 16384 };
+
+/// header of an arena chunk, its bytes follow it in the same allocation.
+struct MapArenaChunk {
+	struct MapArenaChunk *next;
+	size_t                size;
+};
+
+/// bump allocator for arena-mode maps.
+/// nothing is freed on its own, `map_arena_reset` rewinds to the first chunk
+/// and keeps every chunk around for the next round.
+struct MapArena {
+	struct MapArenaChunk *head, *cur;
+	size_t                used; /// bytes taken from `cur`.
+};
+
+CMAP_API uint8_t *_map_arena_bytes(struct MapArenaChunk *chunk) {
+	return ( uint8_t* )(chunk + 1);
+}
+
+/// returns `bytes` bytes aligned for any payload, or NULL if memory ran out.
+CMAP_API void *map_arena_alloc(struct MapArena *arena, size_t bytes) {
+	bytes = (bytes + 7) & ~( size_t )7;
+	if( arena->cur==NULL || arena->used + bytes > arena->cur->size ) {
+		/// reuse the kept chunk after `cur` when it's big enough, otherwise splice a new one in.
+		struct MapArenaChunk *next = (arena->cur != NULL)? arena->cur->next : arena->head;
+		if( next==NULL || bytes > next->size ) {
+			const size_t size = (bytes > MAP_ARENA_CHUNK)? bytes : MAP_ARENA_CHUNK;
+			struct MapArenaChunk *chunk = ( struct MapArenaChunk* )malloc(sizeof *chunk + size);
+			if( chunk==NULL )
+				return NULL;
+			
+			chunk->size = size;
+			chunk->next = next;
+			if( arena->cur != NULL )
+				arena->cur->next = chunk;
+			else
+				arena->head = chunk;
+			next = chunk;
+		}
+		arena->cur = next;
+		arena->used = 0;
 	}
-	return h;
+	void *p = _map_arena_bytes(arena->cur) + arena->used;
+	arena->used += bytes;
+	return p;
+}
+
+/// forgets every allocation without freeing anything, the chunks stay for reuse.
+CMAP_API void map_arena_reset(struct MapArena *arena) {
+	arena->cur = NULL;
+	arena->used = 0;
+}
+
+/// frees the chunks past the one currently being filled.
+CMAP_API void map_arena_trim(struct MapArena *arena) {
+	struct MapArenaChunk **link = (arena->cur != NULL)? &arena->cur->next : &arena->head;
+	for( struct MapArenaChunk *chunk = *link; chunk != NULL; ) {
+		struct MapArenaChunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	*link = NULL;
+}
+
+/// makes sure the next `bytes` bytes come out of one chunk without another malloc.
+CMAP_API bool map_arena_reserve(struct MapArena *arena, const size_t bytes) {
+	if( map_arena_alloc(arena, bytes)==NULL )
+		return false;
+	
+	arena->used -= (bytes + 7) & ~( size_t )7;
+	return true;
+}
+
+CMAP_API void map_arena_clear(struct MapArena *arena) {
+	map_arena_reset(arena);
+	map_arena_trim(arena);
 }
 
 
@@ -38,9 +184,123 @@ enum MapEntryType {
 	StrEntry
 };
 
+enum { MAP_VAL_INLINE = 24 };
+
+/// array or string payload, either cell_t[] or char[].
+/// payloads up to 24 bytes (6 cells or 23 chars) are kept inline, `cap` is 0 then.
+/// larger ones spill to the heap and `cap` is the heap buffer's size in bytes.
+struct MapValue {
+	union {
+		uint8_t  small[MAP_VAL_INLINE];
+		uint8_t *heap;
+	} s;
+	size_t cap;
+	size_t len; /// in elements, not counting a string's 0 terminator.
+};
+
+CMAP_API uint8_t *map_value_data(const struct MapValue *v) {
+	return( v->cap > 0 )? v->s.heap : ( uint8_t* )v->s.small;
+}
+
+CMAP_API void map_value_clear(struct MapValue *v) {
+	if( v->cap > 0 )
+		free(v->s.heap);
+	memset(v, 0, sizeof *v);
+}
+
+/// copies `vlen` elements of `arr` into `v`, reusing its buffer when it's big enough.
+/// a bigger buffer comes from `arena` if given, the heap otherwise.
+/// on allocation failure, `v` is left untouched.
+CMAP_API bool map_value_set(struct MapValue *v, const uint8_t *arr, const size_t elen, const size_t vlen, const bool is_str, struct MapArena *arena) {
+	const size_t bytes = elen * vlen;
+	const size_t need = (is_str)? bytes + 1 : bytes;
+	if( need > v->cap && need > MAP_VAL_INLINE ) {
+		uint8_t *buf = (arena != NULL)?
+			( uint8_t* )map_arena_alloc(arena, need)
+			: ( uint8_t* )realloc((v->cap > 0)? v->s.heap : NULL, need);
+		if( buf==NULL )
+			return false;
+		v->s.heap = buf;
+		v->cap = need;
+	}
+	uint8_t *data = map_value_data(v);
+	if( bytes > 0 )
+		memmove(data, arr, bytes);
+	if( is_str )
+		data[bytes] = 0;
+	v->len = vlen;
+	return true;
+}
+
+/// copies up to `n` elements starting at element `offset` out of `v` into `out`.
+/// returns how many were copied, fewer than `n` when the payload ends first.
+CMAP_API size_t map_value_read(const struct MapValue *v, const size_t elen, const size_t offset, void *out, const size_t n) {
+	if( offset >= v->len )
+		return 0;
+	
+	const size_t count = (n < v->len - offset)? n : v->len - offset;
+	memcpy(out, map_value_data(v) + offset * elen, count * elen);
+	return count;
+}
+
+/// overwrites up to `n` elements of `v` in place starting at element `offset`, never resizes it.
+/// returns how many were written, fewer than `n` when the payload ends first.
+CMAP_API size_t map_value_write(struct MapValue *v, const size_t elen, const size_t offset, const void *in, const size_t n) {
+	if( offset >= v->len )
+		return 0;
+	
+	const size_t count = (n < v->len - offset)? n : v->len - offset;
+	memmove(map_value_data(v) + offset * elen, in, count * elen);
+	return count;
+}
+
+/// appends `n` elements of `arr` to `v`, growing its buffer geometrically so repeated appends are amortized O(1).
+/// a bigger buffer comes from `arena` if given, the heap otherwise.
+/// on allocation failure, `v` is left untouched.
+CMAP_API bool map_value_append(struct MapValue *v, const uint8_t *arr, const size_t elen, const size_t n, const bool is_str, struct MapArena *arena) {
+	const size_t used = elen * v->len;
+	const size_t bytes = elen * n;
+	const size_t need = (is_str)? used + bytes + 1 : used + bytes;
+	const size_t have = (v->cap > 0)? v->cap : MAP_VAL_INLINE;
+	if( need > have ) {
+		size_t cap = have * 2;
+		while( cap < need )
+			cap *= 2;
+		
+		uint8_t *buf = NULL;
+		if( arena != NULL || v->cap==0 ) {
+			buf = (arena != NULL)? ( uint8_t* )map_arena_alloc(arena, cap) : ( uint8_t* )malloc(cap);
+			if( buf != NULL )
+				memcpy(buf, map_value_data(v), used);
+		} else {
+			buf = ( uint8_t* )realloc(v->s.heap, cap);
+		}
+		if( buf==NULL )
+			return false;
+		v->s.heap = buf;
+		v->cap = cap;
+	}
+	uint8_t *data = map_value_data(v);
+	memcpy(data + used, arr, bytes);
+	if( is_str )
+		data[used + bytes] = 0;
+	v->len += n;
+	return true;
+}
+
+/// removes the last element of `v` into `out`, the buffer is kept for the next append.
+CMAP_API bool map_value_pop(struct MapValue *v, const size_t elen, void *out) {
+	if( v->len==0 )
+		return false;
+	
+	v->len--;
+	memcpy(out, map_value_data(v) + v->len * elen, elen);
+	return true;
+}
+
 union MapEntryData {
-	cell_t        i;
-	struct CArray a; /// either cell_t* or char*.
+	cell_t          i;
+	struct MapValue a;
 };
 
 CMAP_API union MapEntryData entry_data_from_int(const cell_t n) {
@@ -54,39 +314,331 @@ CMAP_API union MapEntryData entry_data_from_array(uint8_t *arr, const size_t ele
 	if( is_str && vlen==0 )
 		vlen = strlen(( char* )arr);
 	
-	carray_reserve(&d.a, elen, (is_str)? vlen+1 : vlen);
-	carray_insert(&d.a, arr, elen * vlen);
-	d.a.len = vlen;
+	map_value_set(&d.a, arr, elen, vlen, is_str, NULL);
 	return d;
 }
 
 
+enum { MAP_KEY_INLINE = 24 };
+
+/// a map can mix key types, equal bits of different types are different keys.
+enum MapKeyType {
+	StrKey,
+	CellKey,
+	WideKey,   /// 64-bit, e.g. SteamID64.
+	InternKey, /// string stored once in a shared `MapKeyPool`, `num` holds its address.
+};
+
+/// string keys up to 23 chars live inside the entry so comparing them
+/// doesn't chase a pointer and inserting them doesn't allocate.
+/// integer keys, 32 or 64-bit, are stored in `num` and compared with one integer compare.
+struct MapKey {
+	union {
+		char     small[MAP_KEY_INLINE];
+		char    *heap;
+		uint64_t num;
+	} s;
+	uint32_t len;  /// string keys only.
+	uint32_t type;
+};
+
+/// a key being looked up, borrowed from the caller.
+/// nothing is copied until it gets inserted.
+struct MapKeyView {
+	const char     *str;
+	uint64_t        num;
+	size_t          len;
+	enum MapKeyType type;
+};
+
+CMAP_API struct MapKeyView map_str_key(const char *cstr) {
+	const struct MapKeyView v = { cstr, 0, strlen(cstr), StrKey };
+	return v;
+}
+
+CMAP_API struct MapKeyView map_cell_key(const cell_t n) {
+	const struct MapKeyView v = { NULL, ( uint32_t )n, sizeof n, CellKey };
+	return v;
+}
+
+CMAP_API struct MapKeyView map_wide_key(const uint64_t n) {
+	const struct MapKeyView v = { NULL, n, sizeof n, WideKey };
+	return v;
+}
+
+
+/// a string key kept once for every map sharing a `MapKeyPool`.
+/// its hash is computed once with the pool's seed and reused by every map.
+struct MapInterned {
+	struct MapKeyPool *pool;
+	size_t             hash;
+	size_t             refs; /// entries using it, it's freed when this drops to 0.
+	uint32_t           len;
+	uint32_t           token; /// 1-based position in the pool's `tokens`, 0 if no token was made for it.
+	char               str[1]; /// really `len + 1` bytes.
+};
+
+/// set of interned keys, linear probing over `MapInterned*[cap]`, `cap` a power of 2.
+struct MapKeyPool {
+	struct MapInterned **slots;
+	size_t               cap, len;
+	struct CArray        tokens; /// `MapInterned*`, a token keeps its key alive until the pool is cleared.
+	uint64_t             seed;
+};
+
+CMAP_API void map_key_pool_init(struct MapKeyPool *pool) {
+	memset(pool, 0, sizeof *pool);
+	pool->seed = _make_hash_seed(pool);
+}
+
+/// frees every interned key, only safe once no map uses the pool anymore.
+CMAP_API void map_key_pool_clear(struct MapKeyPool *pool) {
+	for( size_t i=0; i<pool->cap; i++ )
+		free(pool->slots[i]);
+	free(pool->slots);
+	pool->slots = NULL;
+	pool->cap = pool->len = 0;
+	carray_clear(&pool->tokens);
+}
+
+CMAP_API struct MapInterned *_key_pool_find(const struct MapKeyPool *pool, const char *str, const size_t len, const size_t hash) {
+	if( pool->cap==0 )
+		return NULL;
+	
+	const size_t mask = pool->cap - 1;
+	for( size_t i = hash & mask; pool->slots[i] != NULL; i = (i + 1) & mask ) {
+		struct MapInterned *ik = pool->slots[i];
+		if( ik->hash==hash && ik->len==len && !memcmp(ik->str, str, len) )
+			return ik;
+	}
+	return NULL;
+}
+
+CMAP_API void _key_pool_place(struct MapInterned **slots, const size_t cap, struct MapInterned *ik) {
+	size_t i = ik->hash & (cap - 1);
+	while( slots[i] != NULL )
+		i = (i + 1) & (cap - 1);
+	slots[i] = ik;
+}
+
+/// returns the interned copy of a string key or NULL if no map uses it.
+CMAP_API struct MapInterned *map_key_pool_get(const struct MapKeyPool *pool, const struct MapKeyView *key) {
+	return _key_pool_find(pool, key->str, key->len, str_hash(key->str, key->len, pool->seed));
+}
+
+/// finds or adds a string key, a new one starts with no references.
+CMAP_API struct MapInterned *map_key_pool_intern(struct MapKeyPool *pool, const struct MapKeyView *key) {
+	const size_t hash = str_hash(key->str, key->len, pool->seed);
+	struct MapInterned *ik = _key_pool_find(pool, key->str, key->len, hash);
+	if( ik != NULL )
+		return ik;
+	
+	if( (pool->len + 1) * 4 > pool->cap * 3 ) {
+		const size_t cap = (pool->cap==0)? 64 : pool->cap << 1;
+		struct MapInterned **slots = ( struct MapInterned** )calloc(cap, sizeof *slots);
+		if( slots==NULL )
+			return NULL;
+		
+		for( size_t i=0; i<pool->cap; i++ )
+			if( pool->slots[i] != NULL )
+				_key_pool_place(slots, cap, pool->slots[i]);
+		free(pool->slots);
+		pool->slots = slots;
+		pool->cap = cap;
+	}
+	
+	ik = ( struct MapInterned* )malloc(sizeof *ik + key->len);
+	if( ik==NULL )
+		return NULL;
+	
+	ik->pool = pool;
+	ik->hash = hash;
+	ik->refs = 0;
+	ik->len = ( uint32_t )key->len;
+	ik->token = 0;
+	memcpy(ik->str, key->str, key->len);
+	ik->str[key->len] = 0;
+	_key_pool_place(pool->slots, pool->cap, ik);
+	pool->len++;
+	return ik;
+}
+
+/// frees an interned key once nothing references it.
+CMAP_API void map_key_pool_drop_unused(struct MapInterned *ik) {
+	if( ik->refs > 0 )
+		return;
+	
+	struct MapKeyPool *pool = ik->pool;
+	const size_t mask = pool->cap - 1;
+	size_t i = ik->hash & mask;
+	while( pool->slots[i] != ik )
+		i = (i + 1) & mask;
+	
+	/// backward-shift deletion, pull later keys of the cluster into the gap if their home allows it.
+	for( size_t j = (i + 1) & mask; pool->slots[j] != NULL; j = (j + 1) & mask ) {
+		const size_t home = pool->slots[j]->hash & mask;
+		if( ((j - home) & mask) >= ((j - i) & mask) ) {
+			pool->slots[i] = pool->slots[j];
+			i = j;
+		}
+	}
+	pool->slots[i] = NULL;
+	pool->len--;
+	free(ik);
+}
+
+/** map_key_pool_token
+ * returns a small number standing for the interned `key`, the same string always gets the same token.
+ * the key stays interned for as long as the pool lives so the token never dangles.
+ * returns 0 if memory ran out.
+ */
+CMAP_API uint32_t map_key_pool_token(struct MapKeyPool *pool, const struct MapKeyView *key) {
+	struct MapInterned *ik = map_key_pool_intern(pool, key);
+	if( ik==NULL )
+		return 0;
+	else if( ik->token != 0 )
+		return ik->token;
+	
+	if( carray_full(&pool->tokens) && !carray_grow(&pool->tokens, sizeof ik) ) {
+		map_key_pool_drop_unused(ik);
+		return 0;
+	}
+	carray_insert(&pool->tokens, &ik, sizeof ik);
+	ik->token = ( uint32_t )pool->tokens.len;
+	ik->refs++;
+	return ik->token;
+}
+
+/// returns the interned key behind `token` or NULL if the pool never made it.
+CMAP_API struct MapInterned *map_key_pool_from_token(const struct MapKeyPool *pool, const uint32_t token) {
+	if( token==0 || token > pool->tokens.len )
+		return NULL;
+	return *( struct MapInterned** )carray_get(&pool->tokens, token - 1, sizeof(struct MapInterned*));
+}
+
+CMAP_API struct MapInterned *map_interned(const uint64_t num) {
+	return ( struct MapInterned* )( uintptr_t )num;
+}
+
+CMAP_API struct MapKeyView map_interned_key(const struct MapInterned *ik) {
+	const struct MapKeyView v = { ik->str, ( uintptr_t )ik, ik->len, InternKey };
+	return v;
+}
+
+/// long keys come from `arena` if given, the heap otherwise.
+CMAP_API bool map_key_make(struct MapKey *k, const struct MapKeyView *v, struct MapArena *arena) {
+	k->type = v->type;
+	if( v->type==InternKey ) {
+		k->s.num = v->num;
+		k->len = ( uint32_t )v->len;
+		map_interned(v->num)->refs++;
+		return true;
+	} else if( v->type != StrKey ) {
+		k->s.num = v->num;
+		return true;
+	}
+	
+	char *buf = k->s.small;
+	if( v->len >= MAP_KEY_INLINE ) {
+		buf = k->s.heap = ( char* )((arena != NULL)? map_arena_alloc(arena, v->len + 1) : malloc(v->len + 1));
+		if( buf==NULL )
+			return false;
+	}
+	memcpy(buf, v->str, v->len);
+	buf[v->len] = 0;
+	k->len = ( uint32_t )v->len;
+	return true;
+}
+
+/// the key's text, only meaningful for `StrKey` and `InternKey` keys.
+CMAP_API const char *map_key_cstr(const struct MapKey *k) {
+	if( k->type==InternKey )
+		return map_interned(k->s.num)->str;
+	return( k->len < MAP_KEY_INLINE )? k->s.small : k->s.heap;
+}
+
+/// a view of a stored key, e.g. to copy it into another map.
+CMAP_API struct MapKeyView map_key_view(const struct MapKey *k) {
+	switch( k->type ) {
+		case InternKey: return map_interned_key(map_interned(k->s.num));
+		case CellKey:   return map_cell_key(( cell_t )k->s.num);
+		case WideKey:   return map_wide_key(k->s.num);
+		default: {
+			const struct MapKeyView v = { map_key_cstr(k), 0, k->len, StrKey };
+			return v;
+		}
+	}
+}
+
+/// a plain string matches an interned key with the same text, two interned keys only match themselves.
+CMAP_API bool map_key_eq(const struct MapKey *k, const struct MapKeyView *v) {
+	if( v->type != StrKey )
+		return k->type==v->type && k->s.num==v->num;
+	return( k->type==StrKey || k->type==InternKey ) && k->len==v->len && !memcmp(map_key_cstr(k), v->str, v->len);
+}
+
+CMAP_API void map_key_clear(struct MapKey *k) {
+	if( k->type==InternKey ) {
+		struct MapInterned *ik = map_interned(k->s.num);
+		ik->refs--;
+		map_key_pool_drop_unused(ik);
+	} else if( k->type==StrKey && k->len >= MAP_KEY_INLINE ) {
+		free(k->s.heap);
+	}
+	memset(k, 0, sizeof *k);
+}
+
+
 /// Not as efficient as StringMap's entry techniques but meh.
 struct MapEntry {
 	union MapEntryData data;
-	struct CStr        key;    /// string key;
+	struct MapKey      key;
 	size_t             hash;
+	size_t             idx;    /// position in the map's insertion-order `vec`.
 	enum MapEntryType  tag;
+	uint32_t           id;     /// 1-based slot in the map's `ids`, 0 until `map_entry_id` hands one out.
 };
 
 
-CMAP_API struct MapEntry *new_map_entry(const char *cstr, const enum MapEntryType tag, const union MapEntryData data) {
-	struct MapEntry *entry = ( struct MapEntry* )calloc(1, sizeof *entry);
-	if( entry != NULL ) {
-		entry->data = data;
-		entry->tag = tag;
-		entry->key = cstring_create(cstr);
-		entry->hash = str_hash(cstr);
+/// frees the old payload if needed and takes ownership of `data`.
+CMAP_API void map_entry_assign(struct MapEntry *entry, const enum MapEntryType tag, const union MapEntryData data) {
+	switch( entry->tag ) {
+		case StrEntry:
+		case ArrayEntry:
+			map_value_clear(&entry->data.a); break;
+		default: break;
 	}
-	return entry;
+	entry->tag = tag;
+	entry->data = data;
+}
+
+/// stores an array or string payload, overwriting in place when the entry
+/// already holds one so repeated sets of the same size don't allocate.
+/// a string's length is taken from `arr` if `vlen` is 0.
+/// `arena` is the owning map's arena, if it has one.
+CMAP_API bool map_entry_set_array(struct MapEntry *entry, const enum MapEntryType tag, const uint8_t *arr, const size_t elen, size_t vlen, struct MapArena *arena) {
+	const bool is_str = tag==StrEntry;
+	if( is_str && vlen==0 )
+		vlen = strlen(( const char* )arr);
+	
+	if( entry->tag != ArrayEntry && entry->tag != StrEntry ) {
+		union MapEntryData d = {0};
+		if( !map_value_set(&d.a, arr, elen, vlen, is_str, arena) )
+			return false;
+		entry->data = d;
+	} else if( !map_value_set(&entry->data.a, arr, elen, vlen, is_str, arena) ) {
+		return false;
+	}
+	entry->tag = tag;
+	return true;
 }
 
 CMAP_API void map_entry_clear(struct MapEntry *entry) {
-	cstring_clear(&entry->key);
+	map_key_clear(&entry->key);
 	switch( entry->tag ) {
 		case ArrayEntry:
 		case StrEntry:
-			carray_clear(&entry->data.a); break;
+			map_value_clear(&entry->data.a); break;
 		default: break;
 	}
 	memset(entry, 0, sizeof *entry);
@@ -100,40 +652,423 @@ CMAP_API void map_entry_free(struct MapEntry **entry_ref) {
 	free(*entry_ref); *entry_ref = NULL;
 }
 
+
+enum {
+	MAP_SLAB_MIN = 16,
+	MAP_SLAB_MAX = 1024,
+};
+
+/// header of a block of entries, the entries follow it in the same allocation.
+struct MapSlab {
+	struct MapSlab *next;
+	size_t          count;
+};
+
+/// per-map entry allocator.
+/// entries are carved out of slabs that double in size up to `MAP_SLAB_MAX`
+/// and freed entries go on a free list that's reused before any new slab is made,
+/// so churning keys doesn't hit malloc or fragment the heap.
+struct MapPool {
+	struct MapSlab  *slabs;
+	struct MapEntry *free; /// linked through the first pointer of each free entry.
+	size_t           total, used;
+};
+
+CMAP_API struct MapEntry *_map_slab_entries(struct MapSlab *slab) {
+	return ( struct MapEntry* )(slab + 1);
+}
+
+CMAP_API bool map_pool_add_slab(struct MapPool *pool, const size_t count) {
+	struct MapSlab *slab = NULL;
+	if( count > (SIZE_MAX - sizeof *slab) / sizeof(struct MapEntry) )
+		return false;
+	
+	slab = ( struct MapSlab* )malloc(sizeof *slab + count * sizeof(struct MapEntry));
+	if( slab==NULL )
+		return false;
+	
+	slab->count = count;
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+	
+	/// link back to front so entries hand out in address order.
+	struct MapEntry *entries = _map_slab_entries(slab);
+	for( size_t i=count; i-- > 0; ) {
+		*( struct MapEntry** )&entries[i] = pool->free;
+		pool->free = &entries[i];
+	}
+	pool->total += count;
+	return true;
+}
+
+/// returns a zeroed entry or NULL if memory ran out.
+CMAP_API struct MapEntry *map_pool_alloc(struct MapPool *pool) {
+	if( pool->free==NULL ) {
+		size_t count = pool->total;
+		if( count < MAP_SLAB_MIN )
+			count = MAP_SLAB_MIN;
+		else if( count > MAP_SLAB_MAX )
+			count = MAP_SLAB_MAX;
+		
+		if( !map_pool_add_slab(pool, count) )
+			return NULL;
+	}
+	struct MapEntry *entry = pool->free;
+	pool->free = *( struct MapEntry** )entry;
+	memset(entry, 0, sizeof *entry);
+	pool->used++;
+	return entry;
+}
+
+/// puts an entry back on the free list, its key and payload must be cleared already.
+CMAP_API void map_pool_release(struct MapPool *pool, struct MapEntry *entry) {
+	*( struct MapEntry** )entry = pool->free;
+	pool->free = entry;
+	pool->used--;
+}
+
+/// makes sure `entries` entries fit without another slab, using one slab for the difference.
+CMAP_API bool map_pool_reserve(struct MapPool *pool, const size_t entries) {
+	return entries <= pool->total || map_pool_add_slab(pool, entries - pool->total);
+}
+
+/// frees every slab, any entries still in use are gone with them.
+CMAP_API void map_pool_clear(struct MapPool *pool) {
+	for( struct MapSlab *slab = pool->slabs; slab != NULL; ) {
+		struct MapSlab *next = slab->next;
+		free(slab);
+		slab = next;
+	}
+	memset(pool, 0, sizeof *pool);
+}
+
 /*****************************************************************************************/
 
 
+/// a slot in the flat open-addressing table.
+/// `hash` keeps the low 32 bits of the entry's hash so probing can
+/// reject mismatches without chasing the entry pointer.
+struct MapSlot {
+	struct MapEntry *entry; /// NULL if the slot is empty.
+	uint32_t         hash;
+	uint32_t         dist;  /// probe distance from the home slot (Robin Hood).
+};
+
+/// returns the slot index holding `key` or SIZE_MAX if not found.
+CMAP_API size_t _slots_find(const struct MapSlot *slots, const size_t cap, const struct MapKeyView *key, const size_t hash) {
+	const size_t mask = cap - 1;
+	const uint32_t frag = ( uint32_t )hash;
+	for( size_t i = hash & mask, dist = 0;; i = (i + 1) & mask, dist++ ) {
+		const struct MapSlot *slot = &slots[i];
+		/// Robin Hood invariant: if we've probed further than the resident, the key isn't here.
+		if( slot->entry==NULL || slot->dist < dist )
+			return SIZE_MAX;
+		else if( slot->hash==frag && map_key_eq(&slot->entry->key, key) )
+			return i;
+	}
+}
+
+/// returns the slot index holding `entry` or SIZE_MAX if not found.
+CMAP_API size_t _slots_find_entry(const struct MapSlot *slots, const size_t cap, const struct MapEntry *entry) {
+	const size_t mask = cap - 1;
+	for( size_t i = entry->hash & mask, dist = 0;; i = (i + 1) & mask, dist++ ) {
+		const struct MapSlot *slot = &slots[i];
+		if( slot->entry==NULL || slot->dist < dist )
+			return SIZE_MAX;
+		else if( slot->entry==entry )
+			return i;
+	}
+}
+
+/// Robin Hood placement of `entry` starting at slot `i`, `dist` away from its home slot.
+CMAP_API void _slots_place(struct MapSlot *slots, const size_t cap, size_t i, const size_t dist, struct MapEntry *entry) {
+	const size_t mask = cap - 1;
+	struct MapSlot carry = { entry, ( uint32_t )entry->hash, ( uint32_t )dist };
+	for( ;; i = (i + 1) & mask, carry.dist++ ) {
+		struct MapSlot *slot = &slots[i];
+		if( slot->entry==NULL ) {
+			*slot = carry;
+			return;
+		} else if( slot->dist < carry.dist ) {
+			/// steal from the rich: the resident is closer to home than we are.
+			const struct MapSlot t = *slot;
+			*slot = carry;
+			carry = t;
+		}
+	}
+}
+
+/// backward-shift deletion, keeps probe sequences intact without tombstones.
+CMAP_API void _slots_erase(struct MapSlot *slots, const size_t cap, size_t i) {
+	const size_t mask = cap - 1;
+	for( size_t n = (i + 1) & mask; slots[n].entry != NULL && slots[n].dist > 0; i = n, n = (n + 1) & mask ) {
+		slots[i] = slots[n];
+		slots[i].dist--;
+	}
+	memset(&slots[i], 0, sizeof slots[i]);
+}
+
+
+enum {
+	MAP_MIN_CAP     = 8,
+	/// most entries an incremental rehash moves per mutating call.
+	MAP_REHASH_STEP = 64,
+};
+
+enum MapFlags {
+	MapDefault           = 0,
+	/// removals leave holes that index access reports as missing,
+	/// positions only shift on `map_compact` or when inserting past the hole threshold.
+	MapStableIndices     = 1 << 0,
+	/// growing keeps the old table around and drains it `MAP_REHASH_STEP` slots
+	/// per mutating call instead of re-inserting everything at once.
+	MapIncrementalRehash = 1 << 1,
+	/// entries, long keys and spilled values are bump-allocated from a per-map arena.
+	/// removing an entry doesn't give its memory back, `map_clear` rewinds the whole arena instead.
+	MapArenaAlloc        = 1 << 2,
+	/// string keys are stored once in the `MapKeyPool` given to `new_map` and shared with other maps.
+	/// their hash is computed once per string, interned keys compare by pointer.
+	MapInternKeys        = 1 << 3,
+};
+
+/// entry ids are `(generation << MAP_ID_BITS) | slot`, `slot` being 1-based into `CMap::ids`.
+/// a removed entry bumps its slot's generation so ids still held by plugins stop matching.
+/// the generation has `MAP_ID_GEN_BITS` bits so ids stay below 2^31 and are never negative as a Pawn cell.
+/// it never wraps, a slot that has used up its generations is retired instead of going back on the free list.
+enum { MAP_ID_BITS = 20, MAP_ID_GEN_BITS = 11 };
+
+struct MapIdSlot {
+	struct MapEntry *entry; /// NULL while the slot is on the free list.
+	uint32_t         gen;
+	uint32_t         next;  /// next free slot, 1-based.
+};
+
 struct CMap {
 	/// `vec` saves insertion order, `MapEntry*[cap]`.
-	/// `buckets` is an array of arrays of `MapEntry*` aka `MapEntry*[1st cap][2nd cap]`.
-	struct CArray  vec, *buckets;
-	size_t         cap,  len;
+	/// removals leave NULL holes in `vec` which get squeezed out lazily by `map_compact`.
+	/// `slots` is a Robin Hood hash table of `MapSlot[cap]`, `cap` is always a power of 2.
+	/// `old_slots` is only set while an incremental rehash drains it, `migrate` is its cursor into `old_slots`.
+	struct CArray   vec;
+	struct MapSlot *slots, *old_slots;
+	size_t          cap,  len, holes;
+	size_t          old_cap, old_len, migrate;
+	size_t          reserved; /// entry count from `new_map`/`map_reserve`, automatic shrinking stops there.
+	struct MapPool  pool;
+	struct MapArena arena;
+	struct MapKeyPool *keys; /// only set for `MapInternKeys` maps.
+	struct CArray   ids;     /// `MapIdSlot`, entries that were given an id.
+	uint32_t        free_id, free_id_tail; /// 1-based ends of the queue of reusable `ids` slots, `free_id` is 0 if none.
+	uint64_t        seed;
+	uint32_t        flags;
+	uintptr_t       user;    /// left to the embedder, the map never reads it and `map_clone` doesn't copy it.
 };
 
-CMAP_API struct CMap *new_map(const size_t def_size = 8ul) {
+CMAP_API size_t _map_round_cap(const size_t size) {
+	return( size <= MAP_MIN_CAP )? MAP_MIN_CAP : _next_pow2(size - 1);
+}
+
+/// smallest table that holds `entries` without crossing the growth point.
+CMAP_API size_t _map_cap_for(const size_t entries) {
+	return _map_round_cap((entries * 4 + 2) / 3);
+}
+
+/// keep load factor at or below 3/4, probe lengths get ugly past that.
+CMAP_API bool _map_needs_grow(const struct CMap *const map) {
+	return (map->len + 1) * 4 > map->cap * 3;
+}
+
+/// shrink once below 1/8 load, halving lands at under 1/4 which is far enough
+/// from the 3/4 growth point that add/remove churn can't make it thrash.
+CMAP_API bool _map_needs_shrink(const struct CMap *const map) {
+	return map->cap > _map_cap_for(map->reserved) && map->len * 8 < map->cap;
+}
+
+/// how many entries fit before the table has to grow.
+CMAP_API size_t map_capacity(const struct CMap *const map) {
+	return map->cap * 3 / 4;
+}
+
+/// the most entries a map can be sized for.
+/// keeps the table, `vec` and entry storage sizes from wrapping around with a 32-bit `size_t`.
+CMAP_API size_t map_max_entries(void) {
+	return (SIZE_MAX / 4) / sizeof(struct MapEntry);
+}
+
+/// where the map's key and value buffers come from, NULL means the heap.
+CMAP_API struct MapArena *map_arena(struct CMap *map) {
+	return( map->flags & MapArenaAlloc )? &map->arena : NULL;
+}
+
+/// returns a zeroed entry from the map's free list, slabs or arena.
+CMAP_API struct MapEntry *_map_new_entry(struct CMap *map) {
+	if( (map->flags & MapArenaAlloc) && map->pool.free==NULL ) {
+		struct MapEntry *entry = ( struct MapEntry* )map_arena_alloc(&map->arena, sizeof *entry);
+		if( entry != NULL ) {
+			memset(entry, 0, sizeof *entry);
+			map->pool.used++;
+		}
+		return entry;
+	}
+	return map_pool_alloc(&map->pool);
+}
+
+/// retires the entry's id, the slot's next user gets a new generation.
+/// freed slots are queued at the tail and reused from the head, so a key churning through
+/// the map walks every free slot instead of burning one slot's generations.
+CMAP_API void _map_drop_id(struct CMap *map, struct MapEntry *entry) {
+	const uint32_t n = entry->id;
+	struct MapIdSlot *slot = ( struct MapIdSlot* )carray_get(&map->ids, n - 1, sizeof *slot);
+	slot->entry = NULL;
+	entry->id = 0;
+	if( ++slot->gen >= (1u << MAP_ID_GEN_BITS) )
+		return; /// out of generations, the slot stays empty so no old id can match again.
+	
+	slot->next = 0;
+	if( map->free_id==0 )
+		map->free_id = n;
+	else
+		(( struct MapIdSlot* )carray_get(&map->ids, map->free_id_tail - 1, sizeof *slot))->next = n;
+	map->free_id_tail = n;
+}
+
+/// recycles an unlinked entry.
+/// in arena mode its key and payload stay in the arena until the next clear.
+CMAP_API void _map_release_entry(struct CMap *map, struct MapEntry *entry) {
+	if( entry->id != 0 )
+		_map_drop_id(map, entry);
+	if( !(map->flags & MapArenaAlloc) )
+		map_entry_clear(entry);
+	else if( entry->key.type==InternKey )
+		map_key_clear(&entry->key);
+	map_pool_release(&map->pool, entry);
+}
+
+/** map_assign
+ * replaces the entry's value with `data`, taking ownership of its heap buffer only if it returns true.
+ * arena-mode maps copy a spilled payload into the arena and free the original.
+ */
+CMAP_API bool map_assign(struct CMap *map, struct MapEntry *entry, const enum MapEntryType tag, union MapEntryData data) {
+	if( !(map->flags & MapArenaAlloc) ) {
+		map_entry_assign(entry, tag, data);
+		return true;
+	} else if( (tag==ArrayEntry || tag==StrEntry) && data.a.cap > 0 ) {
+		uint8_t *buf = ( uint8_t* )map_arena_alloc(&map->arena, data.a.cap);
+		if( buf==NULL )
+			return false;
+		
+		memcpy(buf, data.a.s.heap, data.a.cap);
+		free(data.a.s.heap);
+		data.a.s.heap = buf;
+	}
+	entry->tag = tag;
+	entry->data = data;
+	return true;
+}
+
+CMAP_API bool map_set_array(struct CMap *map, struct MapEntry *entry, const enum MapEntryType tag, const uint8_t *arr, const size_t elen, const size_t vlen) {
+	return map_entry_set_array(entry, tag, arr, elen, vlen, map_arena(map));
+}
+
+/// appends to the array or string `entry` holds in place, an `InvalidEntry` one becomes an empty `tag` entry first.
+/// returns false if the entry holds another type or memory ran out.
+CMAP_API bool map_append_array(struct CMap *map, struct MapEntry *entry, const enum MapEntryType tag, const uint8_t *arr, const size_t elen, const size_t n) {
+	if( entry->tag==InvalidEntry ) {
+		memset(&entry->data, 0, sizeof entry->data);
+		entry->tag = tag;
+	} else if( entry->tag != tag ) {
+		return false;
+	}
+	return map_value_append(&entry->data.a, arr, elen, n, tag==StrEntry, map_arena(map));
+}
+
+/// `def_size` is the number of entries the map holds before it needs to grow.
+/// `keys` is the shared pool `MapInternKeys` maps store their string keys in, it must outlive the map.
+CMAP_API struct CMap *new_map(const size_t def_size = 8ul, const uint32_t flags = MapDefault, struct MapKeyPool *keys = NULL) {
+	if( def_size > map_max_entries() )
+		return NULL;
+	
 	struct CMap *map = ( struct CMap* )calloc(1, sizeof *map);
 	if( map != NULL ) {
+		const size_t cap = _map_cap_for(def_size);
 		map->vec = carray_make(sizeof(struct MapEntry*), def_size);
-		map->buckets = ( struct CArray* )recalloc(map->buckets, def_size, sizeof *map->buckets, map->cap);
-		map->cap = def_size;
-		map->len = 0;
+		map->slots = ( struct MapSlot* )calloc(cap, sizeof *map->slots);
+		if( map->slots==NULL ) {
+			carray_clear(&map->vec);
+			free(map); map = NULL;
+		} else {
+			map->cap = cap;
+			map->len = 0;
+			map->flags = (keys != NULL)? flags : (flags & ~MapInternKeys);
+			map->keys = (map->flags & MapInternKeys)? keys : NULL;
+			map->reserved = def_size;
+			map->seed = _make_hash_seed(map);
+		}
 	}
 	return map;
 }
 
+/// removes all entries but keeps the table so the map stays usable.
 CMAP_API void map_clear(struct CMap *map) {
-	/// easier to destroy the map from the order-preserving vector.
-	for( size_t i=0; i<map->vec.len; i++ ) {
-		struct MapEntry *entry = *( struct MapEntry** )carray_get(&map->vec, i, sizeof entry);
-		map_entry_free(&entry);
+	for( size_t i=0; i<map->ids.len; i++ ) {
+		struct MapIdSlot *slot = ( struct MapIdSlot* )carray_get(&map->ids, i, sizeof *slot);
+		if( slot->entry != NULL )
+			_map_drop_id(map, slot->entry);
 	}
-	carray_clear(&map->vec);
+	if( map->flags & MapArenaAlloc ) {
+		/// every entry, key and spilled value is in the arena, rewinding it drops them all at once.
+		/// interned keys live outside of it and still need their references dropped.
+		if( map->keys != NULL ) {
+			for( size_t i=0; i<map->vec.len; i++ ) {
+				struct MapEntry *entry = *( struct MapEntry** )carray_get(&map->vec, i, sizeof entry);
+				if( entry != NULL )
+					map_key_clear(&entry->key);
+			}
+		}
+		map_arena_reset(&map->arena);
+		map->pool.free = NULL;
+		map->pool.used = 0;
+		map->vec.len = 0;
+	} else {
+		/// easier to destroy the map from the order-preserving vector.
+		/// slabs are kept so refilling the map doesn't allocate again.
+		for( size_t i=0; i<map->vec.len; i++ ) {
+			struct MapEntry *entry = *( struct MapEntry** )carray_get(&map->vec, i, sizeof entry);
+			if( entry != NULL )
+				_map_release_entry(map, entry);
+		}
+		carray_wipe(&map->vec, sizeof(struct MapEntry*));
+	}
+	if( map->slots != NULL )
+		memset(map->slots, 0, map->cap * sizeof *map->slots);
 	
-	for( size_t i=0; i<map->cap; i++ ) {
-		carray_clear(&map->buckets[i]);
+	free(map->old_slots); map->old_slots = NULL;
+	map->old_cap = map->old_len = map->migrate = 0;
+	map->len = map->holes = 0;
+}
+
+/// squeezes the holes out of `vec` in one pass, keeping insertion order.
+CMAP_API void map_compact(struct CMap *map) {
+	if( map->holes==0 )
+		return;
+	
+	struct MapEntry **order = ( struct MapEntry** )map->vec.table;
+	size_t n = 0;
+	for( size_t i=0; i<map->vec.len; i++ ) {
+		if( order[i]==NULL )
+			continue;
+		
+		order[i]->idx = n;
+		order[n++] = order[i];
 	}
-	free(map->buckets); map->buckets = NULL;
-	map->len = map->cap = 0;
+	memset(&order[n], 0, (map->vec.len - n) * sizeof *order);
+	map->vec.len = n;
+	map->holes = 0;
+}
+
+/// how many index positions there are.
+/// in stable-index mode this counts holes too so loops over indices see fixed positions.
+CMAP_API size_t map_span(const struct CMap *map) {
+	return( map->flags & MapStableIndices )? map->vec.len : map->len;
 }
 
 CMAP_API void map_free(struct CMap **map_ref) {
@@ -141,94 +1076,427 @@ CMAP_API void map_free(struct CMap **map_ref) {
 		return;
 	
 	map_clear(*map_ref);
+	map_pool_clear(&(*map_ref)->pool);
+	map_arena_clear(&(*map_ref)->arena);
+	carray_clear(&(*map_ref)->vec);
+	carray_clear(&(*map_ref)->ids);
+	free((*map_ref)->slots);
 	free(*map_ref); *map_ref = NULL;
 }
 
-CMAP_API bool map_has_key(struct CMap *map, const char *key) {
-	const size_t hash = str_hash(key);
-	const size_t index = hash & (map->cap - 1);
-	struct CArray *bucket = &map->buckets[index];
-	for( size_t i=0; i<bucket->len; i++ ) {
-		struct MapEntry *entry = *( struct MapEntry** )carray_get(bucket, i, sizeof entry);
-		if( entry->hash==hash || !strcmp(entry->key.cstr, key) )
-			return true;
+/// bytes an arena-mode copy of `entry` takes from the arena, rounded like `map_arena_alloc` does.
+CMAP_API size_t _map_entry_arena_size(const struct MapEntry *entry) {
+	size_t bytes = (sizeof *entry + 7) & ~( size_t )7;
+	if( entry->key.type==StrKey && entry->key.len >= MAP_KEY_INLINE )
+		bytes += (entry->key.len + 1 + 7) & ~( size_t )7;
+	if( entry->tag==ArrayEntry || entry->tag==StrEntry ) {
+		const size_t need = (entry->tag==StrEntry)? entry->data.a.len + 1 : entry->data.a.len * sizeof(cell_t);
+		if( need > MAP_VAL_INLINE )
+			bytes += (need + 7) & ~( size_t )7;
 	}
-	return false;
+	return bytes;
 }
 
+/// copies `src` into a fresh entry of `map`, keeping its hash.
+CMAP_API struct MapEntry *_map_clone_entry(struct CMap *map, const struct MapEntry *src) {
+	struct MapEntry *entry = _map_new_entry(map);
+	if( entry==NULL )
+		return NULL;
+	
+	const struct MapKeyView key = map_key_view(&src->key);
+	const bool is_value = src->tag==ArrayEntry || src->tag==StrEntry;
+	const size_t elen = (src->tag==StrEntry)? sizeof(char) : sizeof(cell_t);
+	if( !map_key_make(&entry->key, &key, map_arena(map))
+		|| (is_value && !map_value_set(&entry->data.a, map_value_data(&src->data.a), elen, src->data.a.len, src->tag==StrEntry, map_arena(map))) ) {
+		_map_release_entry(map, entry);
+		return NULL;
+	}
+	if( !is_value )
+		entry->data = src->data;
+	entry->tag = src->tag;
+	entry->hash = src->hash;
+	return entry;
+}
+
+/** map_clone
+ * copies `src` with its insertion order, holes included, so indices mean the same in both maps.
+ * the copy gets the same table size and seed, which lets it take over the slot layout
+ * instead of hashing and probing every key again.
+ * entries come from a single slab, arena-mode maps take every entry, long key and spilled value
+ * from one arena chunk sized up front. heap-mode keys and values are freed one by one, so they stay separate.
+ * entry ids aren't copied, they belong to `src`.
+ * returns NULL if memory ran out.
+ */
+CMAP_API struct CMap *map_clone(const struct CMap *src) {
+	struct CMap *map = ( struct CMap* )calloc(1, sizeof *map);
+	if( map==NULL )
+		return NULL;
+	
+	map->flags = src->flags;
+	map->keys = src->keys;
+	map->seed = src->seed;
+	map->reserved = src->reserved;
+	map->cap = src->cap;
+	map->slots = ( struct MapSlot* )calloc(map->cap, sizeof *map->slots);
+	map->vec = carray_make(sizeof(struct MapEntry*), src->vec.len);
+	
+	struct MapEntry *const *order = ( struct MapEntry *const* )src->vec.table;
+	bool reserved = false;
+	if( map->flags & MapArenaAlloc ) {
+		size_t bytes = 0;
+		for( size_t i=0; i<src->vec.len; i++ )
+			if( order[i] != NULL )
+				bytes += _map_entry_arena_size(order[i]);
+		reserved = bytes==0 || map_arena_reserve(&map->arena, bytes);
+	} else {
+		reserved = map_pool_reserve(&map->pool, src->len);
+	}
+	if( map->slots==NULL || map->vec.table==NULL || !reserved ) {
+		map_free(&map);
+		return NULL;
+	}
+	
+	struct MapEntry **copies = ( struct MapEntry** )map->vec.table;
+	for( size_t i=0; i<src->vec.len; i++ ) {
+		if( order[i]==NULL ) {
+			map->holes++;
+		} else if( (copies[i] = _map_clone_entry(map, order[i]))==NULL ) {
+			map->vec.len = i;
+			map_free(&map);
+			return NULL;
+		} else {
+			copies[i]->idx = i;
+			map->len++;
+		}
+	}
+	map->vec.len = src->vec.len;
+	
+	/// mid-rehash entries are split over two tables, the copy gets them all in one.
+	if( src->old_slots != NULL ) {
+		for( size_t i=0; i<map->vec.len; i++ )
+			if( copies[i] != NULL )
+				_slots_place(map->slots, map->cap, copies[i]->hash & (map->cap - 1), 0, copies[i]);
+	} else {
+		for( size_t i=0; i<src->cap; i++ ) {
+			map->slots[i] = src->slots[i];
+			if( src->slots[i].entry != NULL )
+				map->slots[i].entry = copies[src->slots[i].entry->idx];
+		}
+	}
+	return map;
+}
+
+/// returns the slot index holding `key` or SIZE_MAX if not found.
+/// only searches the live table, see `map_key_get` for lookups during an incremental rehash.
+CMAP_API size_t map_find_slot(const struct CMap *map, const struct MapKeyView *key, const size_t hash) {
+	return _slots_find(map->slots, map->cap, key, hash);
+}
+
+/// returns the slot index holding `entry` or SIZE_MAX if not found.
+CMAP_API size_t map_find_entry_slot(const struct CMap *map, const struct MapEntry *entry) {
+	return _slots_find_entry(map->slots, map->cap, entry);
+}
+
+/// integer keys skip the byte loop and go through a single wyhash mix.
+CMAP_API size_t map_hash_key(const struct CMap *map, const struct MapKeyView *key) {
+	if( key->type==InternKey )
+		return map_interned(key->num)->hash;
+	else if( key->type != StrKey )
+		return ( size_t )_wymix(key->num ^ map->seed, 0xe7037ed1a0b428dbull ^ key->type);
+	/// interning maps hash strings like their pool does so plain lookups find interned keys without visiting the pool.
+	return str_hash(key->str, key->len, (map->keys != NULL)? map->keys->seed : map->seed);
+}
+
+/// places `entry` into the table, the caller makes sure there's room and that the key is unique.
 CMAP_API bool map_insert_entry(struct CMap *map, struct MapEntry *entry) {
-	const size_t index = entry->hash & (map->cap - 1);
-	struct CArray *bucket = &map->buckets[index];
+	_slots_place(map->slots, map->cap, entry->hash & (map->cap - 1), 0, entry);
+	return true;
+}
+
+/** map_rehash_step
+ * moves entries from the draining table into the live one, walking `old_slots` from the `migrate` cursor.
+ * `work` bounds how many slots get looked at or moved so the cost per call stays flat,
+ * a whole drain costs at most `old_cap + old_len`.
+ * returns true once there's no rehash in progress.
+ */
+CMAP_API bool map_rehash_step(struct CMap *map, size_t work) {
+	if( map->old_slots==NULL )
+		return true;
 	
-	/// this will run even if the bucket is empty
-	/// as a cap of 0 with len of 0 is still technically full!
-	if( carray_full(bucket) && !carray_grow(bucket, sizeof entry) )
+	/// erasing shifts the rest of the cluster back into the cursor's slot, so it only moves on past an empty one.
+	/// draining-table entries only ever shift backwards, which keeps every slot behind the cursor empty.
+	while( map->old_len > 0 && map->migrate < map->old_cap && work-- > 0 ) {
+		struct MapEntry *entry = map->old_slots[map->migrate].entry;
+		if( entry==NULL ) {
+			map->migrate++;
+			continue;
+		}
+		_slots_erase(map->old_slots, map->old_cap, map->migrate);
+		map_insert_entry(map, entry);
+		map->old_len--;
+	}
+	
+	if( map->old_len > 0 )
 		return false;
 	
-	return carray_insert(bucket, &entry, sizeof entry);
+	free(map->old_slots); map->old_slots = NULL;
+	map->old_cap = map->migrate = 0;
+	return true;
 }
 
 CMAP_API bool map_rehash(struct CMap *map, const size_t new_size) {
-	const size_t old_cap = map->cap;
-	struct CArray *curr = map->buckets;
-	map->buckets = ( struct CArray* )calloc(new_size, sizeof *curr);
-	if( map->buckets==NULL ) {
-		map->buckets = curr;
+	map_rehash_step(map, SIZE_MAX);
+	const size_t new_cap = _map_round_cap(new_size);
+	if( new_cap < map->len )
 		return false;
-	}
-	
-	map->cap = new_size;
-	for( size_t i=0; i<old_cap; i++ )
-		carray_clear(&curr[i]);
 	
-	free(curr);
+	struct MapSlot *slots = ( struct MapSlot* )calloc(new_cap, sizeof *slots);
+	if( slots==NULL )
+		return false;
 	
+	free(map->slots);
+	map->slots = slots;
+	map->cap = new_cap;
 	for( size_t i=0; i<map->vec.len; i++ ) {
 		struct MapEntry *entry = *( struct MapEntry** )carray_get(&map->vec, i, sizeof entry);
-		map_insert_entry(map, entry);
+		if( entry != NULL )
+			map_insert_entry(map, entry);
 	}
 	return true;
 }
 
-CMAP_API bool map_insert(struct CMap *map, const char *key, const enum MapEntryType tag, const union MapEntryData data) {
-	if( map_has_key(map, key) )
-		return false;
-	else if( map->len >= map->cap && !map_rehash(map, map->cap << 1) )
+/** map_rehash_begin
+ * swaps in an empty table of `new_size` and leaves the old one for `map_rehash_step` to drain.
+ * a drain is always over before the next resize, so no call ever pays for a whole table:
+ * - shrinking waits while a drain runs, see `_map_shrink`.
+ * - explicit presizing finishes the drain itself, see `_map_make_room`.
+ * - growing only happens at 3/4 load. any resize leaves the table under half full,
+ *   so at least `new_cap / 4` inserts come before the next grow, each stepping `MAP_REHASH_STEP` (64) slots.
+ *   that's `16 * new_cap` of work against a drain of at most `old_cap + old_len`, under `3 * new_cap` even after a shrink.
+ */
+CMAP_API bool map_rehash_begin(struct CMap *map, const size_t new_size) {
+	/// the above keeps a drain from overlapping a resize, should one still be running it's finished off in one go.
+	if( map->old_slots != NULL )
+		return map_rehash(map, new_size);
+	
+	const size_t new_cap = _map_round_cap(new_size);
+	if( new_cap < map->len )
 		return false;
 	
-	struct MapEntry *entry = new_map_entry(key, tag, data);
-	if( entry==NULL ) {
+	struct MapSlot *slots = ( struct MapSlot* )calloc(new_cap, sizeof *slots);
+	if( slots==NULL )
 		return false;
-	} else if( !map_insert_entry(map, entry)
-				|| (carray_full(&map->vec) && !carray_grow(&map->vec, sizeof entry))
-				|| !carray_insert(&map->vec, &entry, sizeof entry) ) {
-		/// if we can't insert the entry, increase ptr vec size, or insert to ptr vec.
-		map_entry_free(&entry);
+	
+	map->old_slots = map->slots;
+	map->old_cap   = map->cap;
+	map->old_len   = map->len;
+	map->migrate   = 0;
+	map->slots = slots;
+	map->cap = new_cap;
+	if( map->len==0 )
+		map_rehash_step(map, 0);
+	return true;
+}
+
+CMAP_API bool _map_resize(struct CMap *map, const size_t new_size) {
+	return( map->flags & MapIncrementalRehash )? map_rehash_begin(map, new_size) : map_rehash(map, new_size);
+}
+
+CMAP_API bool _map_grow(struct CMap *map) {
+	return _map_resize(map, map->cap << 1);
+}
+
+/// called after removals, gives back table and order memory once the map has emptied out.
+CMAP_API void _map_shrink(struct CMap *map) {
+	/// a shrink waits out a running drain, the next removal tries again.
+	if( map->old_slots==NULL && _map_needs_shrink(map) )
+		_map_resize(map, map->cap >> 1);
+	
+	/// stable-index maps can't compact behind the plugin's back, they trim on request only.
+	if( !(map->flags & MapStableIndices) && map->vec.cap > VEC_DEFAULT_SIZE && map->vec.cap > map->reserved && map->len * 4 < map->vec.cap ) {
+		map_compact(map);
+		if( map->len==0 )
+			carray_clear(&map->vec);
+		else
+			carray_shrink(&map->vec, sizeof(struct MapEntry*), false);
+	}
+	
+	/// partly used slabs stay until `map_trim` repacks them, an emptied map gives them all back.
+	/// an emptied arena map rewinds its arena instead.
+	if( map->len==0 && (map->flags & MapArenaAlloc) ) {
+		map_arena_reset(&map->arena);
+		map->pool.free = NULL;
+	} else if( map->len==0 && map->pool.total > map->reserved ) {
+		map_pool_clear(&map->pool);
+	}
+}
+
+/// finds the entry for `key` in the live table, then the draining one.
+CMAP_API struct MapEntry *_map_find(const struct CMap *map, const struct MapKeyView *key, const size_t hash) {
+	size_t slot = _slots_find(map->slots, map->cap, key, hash);
+	if( slot != SIZE_MAX )
+		return map->slots[slot].entry;
+	else if( map->old_slots != NULL && (slot = _slots_find(map->old_slots, map->old_cap, key, hash)) != SIZE_MAX )
+		return map->old_slots[slot].entry;
+	return NULL;
+}
+
+/// the view to look up an interned key with, maps sharing its pool compare it by pointer.
+/// other maps get its text and hash it themselves.
+CMAP_API struct MapKeyView map_token_key(const struct CMap *map, const struct MapInterned *ik) {
+	if( map->keys==ik->pool )
+		return map_interned_key(ik);
+	
+	const struct MapKeyView v = { ik->str, 0, ik->len, StrKey };
+	return v;
+}
+
+CMAP_API struct MapEntry *map_view_get(const struct CMap *map, const struct MapKeyView *key) {
+	return _map_find(map, key, map_hash_key(map, key));
+}
+
+CMAP_API bool map_has_key(struct CMap *map, const char *key) {
+	const struct MapKeyView v = map_str_key(key);
+	return map_view_get(map, &v) != NULL;
+}
+
+CMAP_API bool map_has_cell(struct CMap *map, const cell_t key) {
+	const struct MapKeyView v = map_cell_key(key);
+	return map_view_get(map, &v) != NULL;
+}
+
+CMAP_API bool map_has_wide(struct CMap *map, const uint64_t key) {
+	const struct MapKeyView v = map_wide_key(key);
+	return map_view_get(map, &v) != NULL;
+}
+
+/// appends `entry` to the insertion order, compacting or growing `vec` as needed.
+CMAP_API bool _map_push_order(struct CMap *map, struct MapEntry *entry) {
+	/// reclaim holes before paying for a bigger order vector.
+	/// stable-index maps only compact once at least half of `vec` is holes.
+	if( carray_full(&map->vec) && (!(map->flags & MapStableIndices) || map->holes * 2 >= map->vec.len) )
+		map_compact(map);
+	
+	if( carray_full(&map->vec) && !carray_grow(&map->vec, sizeof entry) )
 		return false;
+	
+	entry->idx = map->vec.len;
+	return carray_insert(&map->vec, &entry, sizeof entry);
+}
+
+/** map_view_entry
+ * hashes and probes once, returns the entry for `key` or creates an `InvalidEntry` one in its place.
+ * `*inserted` tells which happened, a new entry is expected to be filled in by the caller.
+ * returns NULL only if memory ran out.
+ */
+CMAP_API struct MapEntry *_map_view_entry(struct CMap *map, const struct MapKeyView *key, bool *inserted) {
+	*inserted = false;
+	map_rehash_step(map, MAP_REHASH_STEP);
+	
+	/// growing first keeps the probe position valid for the insert.
+	/// it may grow one insert early for an existing key, which is harmless.
+	if( _map_needs_grow(map) && !_map_grow(map) && map->len + 1 >= map->cap )
+		return NULL;
+	
+	const size_t hash = map_hash_key(map, key);
+	const uint32_t frag = ( uint32_t )hash;
+	const size_t mask = map->cap - 1;
+	size_t i = hash & mask, dist = 0;
+	for( ;; i = (i + 1) & mask, dist++ ) {
+		const struct MapSlot *slot = &map->slots[i];
+		if( slot->entry==NULL || slot->dist < dist )
+			break;
+		else if( slot->hash==frag && map_key_eq(&slot->entry->key, key) )
+			return slot->entry;
+	}
+	
+	if( map->old_slots != NULL ) {
+		const size_t old = _slots_find(map->old_slots, map->old_cap, key, hash);
+		if( old != SIZE_MAX )
+			return map->old_slots[old].entry;
+	}
+	
+	/// not found, `i` is where the key belongs.
+	struct MapEntry *entry = _map_new_entry(map);
+	if( entry==NULL ) {
+		return NULL;
+	} else if( !map_key_make(&entry->key, key, map_arena(map)) || !_map_push_order(map, entry) ) {
+		_map_release_entry(map, entry);
+		return NULL;
 	}
+	entry->hash = hash;
+	_slots_place(map->slots, map->cap, i, dist, entry);
 	map->len++;
-	return true;
+	*inserted = true;
+	return entry;
 }
 
-CMAP_API struct MapEntry *map_key_get(struct CMap *map, const char *key) {
-	if( !map_has_key(map, key) )
-		return NULL;
+CMAP_API struct MapEntry *map_view_entry(struct CMap *map, const struct MapKeyView *key, bool *inserted) {
+	if( map->keys==NULL || key->type != StrKey )
+		return _map_view_entry(map, key, inserted);
 	
-	const size_t hash = str_hash(key);
-	const size_t index = hash & (map->cap - 1);
-	struct CArray *bucket = &map->buckets[index];
-	for( size_t i=0; i<bucket->len; i++ ) {
-		struct MapEntry *entry = *( struct MapEntry** )carray_get(bucket, i, sizeof entry);
-		if( entry->hash==hash || !strcmp(entry->key.cstr, key) )
-			return entry;
+	struct MapInterned *ik = map_key_pool_intern(map->keys, key);
+	if( ik==NULL ) {
+		*inserted = false;
+		return NULL;
 	}
-	return NULL;
+	/// hold a reference so a failed insert can't free `ik` under us.
+	const struct MapKeyView v = map_interned_key(ik);
+	ik->refs++;
+	struct MapEntry *entry = _map_view_entry(map, &v, inserted);
+	ik->refs--;
+	map_key_pool_drop_unused(ik);
+	return entry;
+}
+
+CMAP_API struct MapEntry *map_key_entry(struct CMap *map, const char *key, bool *inserted) {
+	const struct MapKeyView v = map_str_key(key);
+	return map_view_entry(map, &v, inserted);
+}
+
+CMAP_API struct MapEntry *map_cell_entry(struct CMap *map, const cell_t key, bool *inserted) {
+	const struct MapKeyView v = map_cell_key(key);
+	return map_view_entry(map, &v, inserted);
+}
+
+CMAP_API struct MapEntry *map_wide_entry(struct CMap *map, const uint64_t key, bool *inserted) {
+	const struct MapKeyView v = map_wide_key(key);
+	return map_view_entry(map, &v, inserted);
+}
+
+/// takes ownership of `data` only if it returns true.
+CMAP_API bool map_insert(struct CMap *map, const char *key, const enum MapEntryType tag, const union MapEntryData data) {
+	bool inserted = false;
+	struct MapEntry *entry = map_key_entry(map, key, &inserted);
+	if( entry==NULL || !inserted )
+		return false;
+	
+	return map_assign(map, entry, tag, data);
+}
+
+CMAP_API struct MapEntry *map_key_get(struct CMap *map, const char *key) {
+	const struct MapKeyView v = map_str_key(key);
+	return map_view_get(map, &v);
+}
+
+CMAP_API struct MapEntry *map_cell_get(struct CMap *map, const cell_t key) {
+	const struct MapKeyView v = map_cell_key(key);
+	return map_view_get(map, &v);
+}
+
+CMAP_API struct MapEntry *map_wide_get(struct CMap *map, const uint64_t key) {
+	const struct MapKeyView v = map_wide_key(key);
+	return map_view_get(map, &v);
 }
 
 CMAP_API struct MapEntry *map_idx_get(struct CMap *map, const size_t index) {
-	if( index >= map->vec.len )
+	if( index >= map_span(map) )
 		return NULL;
 	
+	/// indices are dense from the outside, settle any pending removals first.
+	if( !(map->flags & MapStableIndices) )
+		map_compact(map);
+	
 	struct MapEntry **entry_ref = ( struct MapEntry** )carray_get(&map->vec, index, sizeof *entry_ref);
 	if( entry_ref==NULL )
 		return NULL;
@@ -236,25 +1504,34 @@ CMAP_API struct MapEntry *map_idx_get(struct CMap *map, const size_t index) {
 	return *entry_ref;
 }
 
-CMAP_API bool map_key_set(struct CMap *map, const char *key, const enum MapEntryType tag, const union MapEntryData data) {
-	if( !map_has_key(map, key) )
-		return map_insert(map, key, tag, data);
+/** map_idx_range
+ * returns the entries at indices `start` up to `start + *count` straight out of `vec`,
+ * `*count` is clamped to what's left of the map. stable-index maps can have NULL holes in the window.
+ * the window is only valid until the map is next modified.
+ */
+CMAP_API struct MapEntry *const *map_idx_range(struct CMap *map, const size_t start, size_t *count) {
+	const size_t span = map_span(map);
+	if( start >= span ) {
+		*count = 0;
+		return NULL;
+	}
+	
+	if( !(map->flags & MapStableIndices) )
+		map_compact(map);
 	
-	struct MapEntry *entry = map_key_get(map, key);
+	if( *count > span - start )
+		*count = span - start;
+	return ( struct MapEntry *const* )carray_get(&map->vec, start, sizeof(struct MapEntry*));
+}
+
+/// takes ownership of `data` only if it returns true.
+CMAP_API bool map_key_set(struct CMap *map, const char *key, const enum MapEntryType tag, const union MapEntryData data) {
+	bool inserted = false;
+	struct MapEntry *entry = map_key_entry(map, key, &inserted);
 	if( entry==NULL )
 		return false;
 	
-	if( tag != entry->tag ) {
-		switch( entry->tag ) {
-			case StrEntry:
-			case ArrayEntry:
-				carray_clear(&entry->data.a); break;
-			default: break;
-		}
-		entry->tag = tag;
-	}
-	entry->data = data;
-	return true;
+	return map_assign(map, entry, tag, data);
 }
 
 CMAP_API bool map_idx_set(struct CMap *map, const size_t index, const enum MapEntryType tag, const union MapEntryData data) {
@@ -262,60 +1539,237 @@ CMAP_API bool map_idx_set(struct CMap *map, const size_t index, const enum MapEn
 	if( entry==NULL )
 		return false;
 	
-	if( tag != entry->tag ) {
-		switch( entry->tag ) {
-			case StrEntry:
-			case ArrayEntry:
-				carray_clear(&entry->data.a); break;
-			default: break;
-		}
-		entry->tag = tag;
+	return map_assign(map, entry, tag, data);
+}
+
+/// removes and frees the entry at slot `slot` of `slots`, which is either the live or the draining table.
+/// the entry's spot in `vec` becomes a hole so this stays O(1).
+CMAP_API void _map_unlink(struct CMap *map, struct MapSlot *slots, const size_t cap, const size_t slot) {
+	struct MapEntry *entry = slots[slot].entry;
+	struct MapEntry **order = ( struct MapEntry** )map->vec.table;
+	if( entry->idx==map->vec.len - 1 && !(map->flags & MapStableIndices) ) {
+		/// popping the tail needs no hole.
+		order[--map->vec.len] = NULL;
+	} else {
+		order[entry->idx] = NULL;
+		map->holes++;
 	}
-	entry->data = data;
+	_slots_erase(slots, cap, slot);
+	if( slots==map->old_slots )
+		map->old_len--;
+	
+	_map_release_entry(map, entry);
+	map->len--;
+}
+
+CMAP_API void map_unlink_slot(struct CMap *map, const size_t slot) {
+	_map_unlink(map, map->slots, map->cap, slot);
+}
+
+CMAP_API bool map_view_rm(struct CMap *map, const struct MapKeyView *key) {
+	map_rehash_step(map, MAP_REHASH_STEP);
+	const size_t hash = map_hash_key(map, key);
+	size_t slot = map_find_slot(map, key, hash);
+	if( slot != SIZE_MAX ) {
+		map_unlink_slot(map, slot);
+	} else if( map->old_slots != NULL && (slot = _slots_find(map->old_slots, map->old_cap, key, hash)) != SIZE_MAX ) {
+		_map_unlink(map, map->old_slots, map->old_cap, slot);
+	} else {
+		return false;
+	}
+	_map_shrink(map);
 	return true;
 }
 
 CMAP_API bool map_key_rm(struct CMap *map, const char *key) {
-	if( !map_has_key(map, key) )
+	const struct MapKeyView v = map_str_key(key);
+	return map_view_rm(map, &v);
+}
+
+CMAP_API bool map_cell_rm(struct CMap *map, const cell_t key) {
+	const struct MapKeyView v = map_cell_key(key);
+	return map_view_rm(map, &v);
+}
+
+CMAP_API bool map_wide_rm(struct CMap *map, const uint64_t key) {
+	const struct MapKeyView v = map_wide_key(key);
+	return map_view_rm(map, &v);
+}
+
+/// removes an entry already found through its index or id.
+CMAP_API bool map_entry_rm(struct CMap *map, struct MapEntry *entry) {
+	size_t slot = map_find_entry_slot(map, entry);
+	if( slot != SIZE_MAX ) {
+		map_unlink_slot(map, slot);
+	} else if( map->old_slots != NULL && (slot = _slots_find_entry(map->old_slots, map->old_cap, entry)) != SIZE_MAX ) {
+		_map_unlink(map, map->old_slots, map->old_cap, slot);
+	} else {
 		return false;
-	
-	const size_t hash = str_hash(key);
-	const size_t index = hash & (map->cap - 1);
-	struct CArray *bucket = &map->buckets[index];
-	for( size_t i=0; i<bucket->len; i++ ) {
-		struct MapEntry *entry = *( struct MapEntry** )carray_get(bucket, i, sizeof entry);
-		if( entry->hash==hash || !strcmp(entry->key.cstr, key) ) {
-			const size_t entry_idx = carray_index_of(&map->vec, &entry, sizeof entry, 0);
-			if( entry_idx==SIZE_MAX )
-				continue;
-			
-			map_entry_free(&entry);
-			carray_del_by_index(bucket,    i,         sizeof entry);
-			carray_del_by_index(&map->vec, entry_idx, sizeof entry);
-			return true;
-		}
 	}
-	return false;
+	_map_shrink(map);
+	return true;
 }
 
 CMAP_API bool map_idx_rm(struct CMap *map, const size_t n) {
+	map_rehash_step(map, MAP_REHASH_STEP);
 	struct MapEntry *entry = map_idx_get(map, n);
-	if( entry==NULL )
+	return entry != NULL && map_entry_rm(map, entry);
+}
+
+/** map_entry_id
+ * returns the entry's id, handing one out the first time it's asked for.
+ * the id stays valid until the entry is removed, no matter how indices shift or the table grows.
+ * an id is never handed out twice by the same map, so a stale id can't resolve to a newer entry.
+ * returns 0 if memory ran out or the map has used up every id slot and its generations.
+ */
+CMAP_API uint32_t map_entry_id(struct CMap *map, struct MapEntry *entry) {
+	if( entry->id==0 ) {
+		if( map->free_id != 0 ) {
+			entry->id = map->free_id;
+			map->free_id = (( struct MapIdSlot* )carray_get(&map->ids, entry->id - 1, sizeof(struct MapIdSlot)))->next;
+		} else {
+			if( map->ids.len >= (1u << MAP_ID_BITS) - 1 )
+				return 0;
+			else if( carray_full(&map->ids) && !carray_grow(&map->ids, sizeof(struct MapIdSlot)) )
+				return 0;
+			
+			const struct MapIdSlot fresh = { NULL, 0, 0 };
+			carray_insert(&map->ids, &fresh, sizeof fresh);
+			entry->id = ( uint32_t )map->ids.len;
+		}
+		(( struct MapIdSlot* )carray_get(&map->ids, entry->id - 1, sizeof(struct MapIdSlot)))->entry = entry;
+	}
+	const struct MapIdSlot *slot = ( const struct MapIdSlot* )carray_get(&map->ids, entry->id - 1, sizeof *slot);
+	return (slot->gen << MAP_ID_BITS) | entry->id;
+}
+
+/// returns the entry behind `id` or NULL if it was removed or never existed, no hashing involved.
+CMAP_API struct MapEntry *map_id_get(const struct CMap *map, const uint32_t id) {
+	const uint32_t n = id & ((1u << MAP_ID_BITS) - 1);
+	if( n==0 || n > map->ids.len )
+		return NULL;
+	
+	const struct MapIdSlot *slot = ( const struct MapIdSlot* )carray_get(&map->ids, n - 1, sizeof *slot);
+	return( slot->gen==(id >> MAP_ID_BITS) )? slot->entry : NULL;
+}
+
+CMAP_API bool map_id_rm(struct CMap *map, const uint32_t id) {
+	map_rehash_step(map, MAP_REHASH_STEP);
+	struct MapEntry *entry = map_id_get(map, id);
+	return entry != NULL && map_entry_rm(map, entry);
+}
+
+/// presizes the table, `vec` and entry storage for `entries` entries.
+/// false without touching the map if `entries` is past `map_max_entries`.
+CMAP_API bool _map_make_room(struct CMap *map, const size_t entries) {
+	if( entries > map_max_entries() )
+		return false;
+	
+	/// holes count against `vec` until they're compacted.
+	const size_t vec_need = entries + (map->vec.len - map->len);
+	if( vec_need > map->vec.cap && !carray_reserve(&map->vec, sizeof(struct MapEntry*), vec_need) )
+		return false;
+	
+	if( map->flags & MapArenaAlloc ) {
+		if( entries > map->pool.used && !map_arena_reserve(&map->arena, (entries - map->pool.used) * sizeof(struct MapEntry)) )
+			return false;
+	} else if( !map_pool_reserve(&map->pool, entries) ) {
 		return false;
+	}
+	
+	const size_t cap = _map_cap_for(entries);
+	if( cap <= map->cap )
+		return true;
+	
+	/// presizing is a batch cost already, it finishes a running drain before starting the next.
+	map_rehash_step(map, SIZE_MAX);
+	return _map_resize(map, cap);
+}
+
+/** map_reserve
+ * presizes both the table and `vec` so `entries` entries go in without a rehash or `vec` regrowth.
+ * the reservation also keeps automatic shrinking from going below it.
+ */
+CMAP_API bool map_reserve(struct CMap *map, const size_t entries) {
+	if( entries > map_max_entries() )
+		return false;
+	
+	map->reserved = entries;
+	return _map_make_room(map, entries);
+}
+
+/** map_prepare_insert
+ * makes room for `n` more entries up front so a batch of inserts never rehashes or regrows midway.
+ * any incremental rehash is finished here too, the batch pays for it once instead of per insert.
+ * unlike `map_reserve` this doesn't stop the map from shrinking later.
+ */
+CMAP_API bool map_prepare_insert(struct CMap *map, const size_t n) {
+	const bool ok = _map_make_room(map, map->len + n);
+	map_rehash_step(map, SIZE_MAX);
+	return ok;
+}
+
+/** map_pool_repack
+ * moves every entry into one exactly sized slab in insertion order and frees the old slabs.
+ * needs a compacted `vec` and no rehash in progress.
+ */
+CMAP_API bool map_pool_repack(struct CMap *map) {
+	if( map->len==0 ) {
+		map_pool_clear(&map->pool);
+		return true;
+	} else if( map->pool.slabs->next==NULL && map->pool.total==map->len ) {
+		return true;
+	}
+	
+	struct MapPool pool;
+	memset(&pool, 0, sizeof pool);
+	if( !map_pool_add_slab(&pool, map->len) )
+		return false;
+	
+	struct MapEntry *entries = _map_slab_entries(pool.slabs);
+	for( size_t i=0; i<map->cap; i++ ) {
+		struct MapSlot *slot = &map->slots[i];
+		if( slot->entry != NULL )
+			slot->entry = &entries[slot->entry->idx];
+	}
+	struct MapEntry **order = ( struct MapEntry** )map->vec.table;
+	for( size_t i=0; i<map->len; i++ ) {
+		entries[i] = *order[i];
+		order[i] = &entries[i];
+		if( entries[i].id != 0 )
+			(( struct MapIdSlot* )carray_get(&map->ids, entries[i].id - 1, sizeof(struct MapIdSlot)))->entry = &entries[i];
+	}
+	pool.free = NULL;
+	pool.used = map->len;
+	map_pool_clear(&map->pool);
+	map->pool = pool;
+	return true;
+}
+
+/** map_trim
+ * releases every spare byte: finishes any rehash, squeezes out holes (even for stable-index maps),
+ * fits `vec` exactly and rehashes into the smallest table that holds the entries.
+ * drops any reservation.
+ */
+CMAP_API bool map_trim(struct CMap *map) {
+	map->reserved = 0;
+	map_rehash_step(map, SIZE_MAX);
+	map_compact(map);
+	if( map->len==0 )
+		carray_clear(&map->vec);
+	else
+		carray_shrink(&map->vec, sizeof(struct MapEntry*), true);
 	
-	const size_t index = entry->hash & (map->cap - 1);
-	struct CArray *bucket = &map->buckets[index];
-	const size_t entry_idx = carray_index_of(bucket, &entry, sizeof entry, 0);
-	if( entry_idx==SIZE_MAX )
+	const size_t cap = _map_cap_for(map->len);
+	if( cap != map->cap && !map_rehash(map, cap) )
 		return false;
 	
-	const bool bucket_res = carray_del_by_index(bucket, entry_idx, sizeof entry);
-	const bool vec_res = carray_del_by_index(&map->vec, n, sizeof entry);
-	if( bucket_res && vec_res ) {
-		map_entry_free(&entry);
+	/// arena entries can't move without copying their payloads too, just drop the unused chunks.
+	if( map->flags & MapArenaAlloc ) {
+		map_arena_trim(&map->arena);
 		return true;
 	}
-	return false;
+	return map_pool_repack(map);
 }
 
 /********************************************************************/
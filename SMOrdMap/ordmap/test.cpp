@@ -1,6 +1,38 @@
 #include <iostream>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+typedef int32_t cell_t; /// normally comes from the SourcePawn headers.
 #include "ordmap.h"
 
+/// checks keep going after a failure so one run reports every broken case, `main` returns nonzero if any failed.
+static int g_failed = 0;
+#define CHECK(cond) do { \
+	if( !(cond) ) { \
+		std::cout << __FILE__ << ":" << __LINE__ << ": check failed: " #cond "\n"; \
+		g_failed++; \
+	} \
+} while( 0 )
+
+static cell_t cell_of(const MapEntry *entry) {
+	return( entry != nullptr && entry->tag==CellEntry )? entry->data.i : -1;
+}
+
+/// `<prefix><i>`, only valid until the next call.
+static const char *key_of(const char *prefix, const cell_t i) {
+	static char key[64];
+	snprintf(key, sizeof key, "%s%d", prefix, i);
+	return key;
+}
+
+/// inserts `<prefix>0` up to `<prefix><n - 1>`, each holding its own number.
+static void fill(CMap *map, const char *prefix, const cell_t n) {
+	for( cell_t i=0; i<n; i++ )
+		CHECK(map_insert(map, key_of(prefix, i), CellEntry, entry_data_from_int(i)));
+}
+
 const char *get_tag_str(const MapEntryType tag) {
 	switch( tag ) {
 		case StrEntry: return "string";
@@ -16,10 +48,14 @@ void print_entry(MapEntry *entry) {
 		return;
 	}
 	
-	std::cout << entry->key.cstr << " | " << get_tag_str(entry->tag) << " | ";
+	if( entry->key.type==CellKey )
+		std::cout << "#" << ( cell_t )entry->key.s.num;
+	else
+		std::cout << map_key_cstr(&entry->key);
+	std::cout << " | " << get_tag_str(entry->tag) << " | ";
 	switch( entry->tag ) {
 		case StrEntry:
-			std::cout << ( char* )entry->data.a.table << " | " << entry->data.a.len << "\n"; break;
+			std::cout << ( char* )map_value_data(&entry->data.a) << " | " << entry->data.a.len << "\n"; break;
 		case CellEntry:
 			std::cout << entry->data.i << "\n"; break;
 		default: break;
@@ -27,13 +63,674 @@ void print_entry(MapEntry *entry) {
 }
 
 void print_map(CMap *map) {
-	std::cout << "\nprinting entire map\nlen: " << map->vec.len << "\n";
-	for( size_t i=0; i<map->vec.len; i++ )
+	std::cout << "\nprinting entire map\nlen: " << map->len << "\n";
+	for( size_t i=0; i<map->len; i++ )
 		print_entry(map_idx_get(map, i));
 	
 	std::cout << "end of map printing\n\n";
 }
 
+/// stable-index maps keep removed positions as holes: the span (`Len`) stays put while `len` (`Count`) drops.
+void test_stable_indices() {
+	CMap *map = new_map(8, MapStableIndices);
+	fill(map, "s", 10);
+	CHECK(map_key_rm(map, "s2"));
+	CHECK(map_idx_rm(map, 5));
+	CHECK(!map_idx_rm(map, 5));
+	
+	CHECK(map->len==8);
+	CHECK(map_span(map)==10);
+	CHECK(map_idx_get(map, 2)==nullptr);
+	CHECK(map_idx_get(map, 5)==nullptr);
+	CHECK(map_idx_get(map, 10)==nullptr);
+	for( cell_t i=0; i<10; i++ )
+		if( i != 2 && i != 5 )
+			CHECK(cell_of(map_idx_get(map, ( size_t )i))==i);
+	
+	/// walking the span and skipping holes visits every live entry once, in insertion order.
+	size_t seen = 0;
+	cell_t last = -1;
+	for( size_t i=0; i<map_span(map); i++ ) {
+		const MapEntry *entry = map_idx_get(map, i);
+		if( entry==nullptr )
+			continue;
+		
+		CHECK(cell_of(entry) > last);
+		last = cell_of(entry);
+		seen++;
+	}
+	CHECK(seen==map->len);
+	
+	/// inserting appends past the holes, compacting closes them.
+	CHECK(map_insert(map, "s10", CellEntry, entry_data_from_int(10)));
+	CHECK(cell_of(map_idx_get(map, 10))==10);
+	map_compact(map);
+	CHECK(map_span(map)==map->len);
+	CHECK(cell_of(map_idx_get(map, 2))==3);
+	CHECK(cell_of(map_idx_get(map, 8))==10);
+	map_free(&map);
+}
+
+/// grows an incremental map until its drain has plenty left, returns how many `<prefix><i>` keys went in.
+static cell_t fill_until_draining(CMap *map, const char *prefix) {
+	cell_t n = 0;
+	/// each mutating call drains a little more, a drain this long outlasts the caller's checks.
+	while( map->old_slots==NULL || map->old_len < 256 ) {
+		CHECK(map_insert(map, key_of(prefix, n), CellEntry, entry_data_from_int(n)));
+		n++;
+	}
+	return n;
+}
+
+/// lookups, inserts and removals have to see both tables while an incremental rehash drains.
+void test_incremental_rehash() {
+	CMap *map = new_map(8, MapIncrementalRehash);
+	const cell_t n = fill_until_draining(map, "r");
+	for( cell_t i=0; i<n; i++ )
+		CHECK(cell_of(map_key_get(map, key_of("r", i)))==i);
+	
+	/// a key still in the draining table isn't inserted twice and can be removed from there.
+	const MapEntry *old = nullptr;
+	for( size_t i=0; i<map->old_cap && old==nullptr; i++ )
+		old = map->old_slots[i].entry;
+	CHECK(old != nullptr);
+	const cell_t old_val = cell_of(old);
+	CHECK(!map_insert(map, key_of("r", old_val), CellEntry, entry_data_from_int(-5)));
+	CHECK(cell_of(map_key_get(map, key_of("r", old_val)))==old_val);
+	
+	CHECK(map_insert(map, "fresh", CellEntry, entry_data_from_int(4242)));
+	CHECK(cell_of(map_key_get(map, "fresh"))==4242);
+	CHECK(map->old_slots != nullptr);
+	
+	const size_t len = map->len;
+	CHECK(map_key_rm(map, key_of("r", old_val)));
+	CHECK(map_key_get(map, key_of("r", old_val))==nullptr);
+	CHECK(map->len==len - 1);
+	CHECK(map->old_slots != nullptr);
+	
+	CHECK(map_rehash_step(map, SIZE_MAX));
+	CHECK(map->old_slots==nullptr);
+	CHECK(map->len==( size_t )n);
+	for( cell_t i=0; i<n; i++ ) {
+		const MapEntry *entry = map_key_get(map, key_of("r", i));
+		CHECK(i==old_val? entry==nullptr : cell_of(entry)==i);
+	}
+	CHECK(cell_of(map_key_get(map, "fresh"))==4242);
+	map_free(&map);
+	
+	/// starting a resize mid-drain finishes the old table instead of stacking a third one.
+	map = new_map(8, MapIncrementalRehash);
+	const cell_t m = fill_until_draining(map, "again");
+	CHECK(map_rehash_begin(map, map->cap * 2));
+	CHECK(map->old_slots==nullptr);
+	for( cell_t i=0; i<m; i++ )
+		CHECK(cell_of(map_key_get(map, key_of("again", i)))==i);
+	map_free(&map);
+}
+
+/// short arrays and strings live inside the entry, longer ones spill to the heap.
+/// overwriting keeps whatever buffer the entry has when it's big enough.
+void test_inline_values() {
+	CMap *map = new_map();
+	cell_t cells[32];
+	for( cell_t i=0; i<32; i++ )
+		cells[i] = i * 3;
+	
+	bool inserted = false;
+	MapEntry *entry = map_key_entry(map, "arr", &inserted);
+	CHECK(entry != nullptr && inserted);
+	CHECK(map_set_array(map, entry, ArrayEntry, ( const uint8_t* )cells, sizeof(cell_t), 4));
+	CHECK(entry->tag==ArrayEntry && entry->data.a.cap==0 && entry->data.a.len==4);
+	CHECK(memcmp(map_value_data(&entry->data.a), cells, 4 * sizeof(cell_t))==0);
+	
+	CHECK(map_set_array(map, entry, ArrayEntry, ( const uint8_t* )cells, sizeof(cell_t), 32));
+	CHECK(entry->data.a.cap==sizeof cells && entry->data.a.len==32);
+	const uint8_t *heap = map_value_data(&entry->data.a);
+	CHECK(memcmp(heap, cells, sizeof cells)==0);
+	
+	/// shorter values, even ones that would fit inline, reuse the heap buffer.
+	CHECK(map_set_array(map, entry, ArrayEntry, ( const uint8_t* )&cells[8], sizeof(cell_t), 20));
+	CHECK(map_value_data(&entry->data.a)==heap && entry->data.a.cap==sizeof cells && entry->data.a.len==20);
+	CHECK(memcmp(heap, &cells[8], 20 * sizeof(cell_t))==0);
+	CHECK(map_set_array(map, entry, StrEntry, ( const uint8_t* )"now a string", sizeof(char), 0));
+	CHECK(entry->tag==StrEntry && map_value_data(&entry->data.a)==heap && entry->data.a.len==12);
+	CHECK(strcmp(( const char* )heap, "now a string")==0);
+	
+	/// a cell value frees the buffer, the next short value is inline again.
+	CHECK(map_assign(map, entry, CellEntry, entry_data_from_int(9)));
+	CHECK(cell_of(entry)==9);
+	CHECK(map_set_array(map, entry, StrEntry, ( const uint8_t* )"23 chars fit inline....", sizeof(char), 0));
+	CHECK(entry->data.a.cap==0 && entry->data.a.len==23);
+	CHECK(strcmp(( const char* )map_value_data(&entry->data.a), "23 chars fit inline....")==0);
+	CHECK(map_set_array(map, entry, StrEntry, ( const uint8_t* )"24 chars spill to heap..", sizeof(char), 0));
+	CHECK(entry->data.a.cap==25 && entry->data.a.len==24);
+	CHECK(strcmp(( const char* )map_value_data(&entry->data.a), "24 chars spill to heap..")==0);
+	
+	/// an empty array copies nothing, not even from a NULL source, and keeps the buffer.
+	CHECK(map_set_array(map, entry, ArrayEntry, nullptr, sizeof(cell_t), 0));
+	CHECK(entry->tag==ArrayEntry && entry->data.a.cap==25 && entry->data.a.len==0);
+	map_free(&map);
+}
+
+/// trimming repacks the surviving entries into one slab, lookups by key, index and id follow them.
+void test_pool_repack() {
+	enum { KEYS = 1000 };
+	CMap *map = new_map();
+	fill(map, "p", KEYS);
+	uint32_t ids[KEYS];
+	for( cell_t i=0; i<KEYS; i++ ) {
+		ids[i] = map_entry_id(map, map_key_get(map, key_of("p", i)));
+		CHECK(ids[i] != 0);
+	}
+	for( cell_t i=0; i<KEYS; i++ )
+		if( i % 10 != 0 )
+			CHECK(map_id_rm(map, ids[i]));
+	
+	CHECK(map->pool.slabs != nullptr && map->pool.slabs->next != nullptr);
+	CHECK(map_trim(map));
+	CHECK(map->pool.slabs != nullptr && map->pool.slabs->next==nullptr);
+	CHECK(map->pool.total==map->len && map->len==KEYS / 10);
+	const MapEntry *slab = _map_slab_entries(map->pool.slabs);
+	for( cell_t i=0; i<KEYS; i++ ) {
+		const MapEntry *entry = map_id_get(map, ids[i]);
+		if( i % 10 != 0 ) {
+			CHECK(entry==nullptr);
+			continue;
+		}
+		CHECK(cell_of(entry)==i);
+		CHECK(entry==map_key_get(map, key_of("p", i)));
+		CHECK(entry==map_idx_get(map, ( size_t )i / 10));
+		CHECK(entry >= slab && entry < slab + map->pool.total);
+	}
+	map_free(&map);
+}
+
+static size_t arena_chunks(const CMap *map) {
+	size_t n = 0;
+	for( const MapArenaChunk *chunk = map->arena.head; chunk != nullptr; chunk = chunk->next )
+		n++;
+	return n;
+}
+
+/// `<i>` keys long enough to spill, each holding a spilled array of `i, i + 1, ...`.
+static void fill_arena(CMap *map, const cell_t n) {
+	cell_t cells[10];
+	for( cell_t i=0; i<n; i++ ) {
+		for( cell_t k=0; k<10; k++ )
+			cells[k] = i + k;
+		
+		bool inserted = false;
+		MapEntry *entry = map_key_entry(map, key_of("a key long enough to leave the entry #", i), &inserted);
+		CHECK(entry != nullptr && inserted);
+		CHECK(map_set_array(map, entry, ArrayEntry, ( const uint8_t* )cells, sizeof(cell_t), 10));
+	}
+}
+
+static bool arena_entry_ok(const MapEntry *entry, const cell_t i) {
+	if( entry==nullptr || entry->tag != ArrayEntry || entry->data.a.len != 10 || entry->data.a.cap==0 )
+		return false;
+	
+	const cell_t *cells = ( const cell_t* )map_value_data(&entry->data.a);
+	for( cell_t k=0; k<10; k++ )
+		if( cells[k] != i + k )
+			return false;
+	return strcmp(map_key_cstr(&entry->key), key_of("a key long enough to leave the entry #", i))==0;
+}
+
+/// arena maps bump-allocate entries, long keys and spilled values, and hand it all back at once on clear.
+void test_arena() {
+	enum { KEYS = 2000 };
+	CMap *map = new_map(8, MapArenaAlloc);
+	fill_arena(map, KEYS);
+	CHECK(map->len==KEYS);
+	CHECK(arena_chunks(map) > 2);
+	for( cell_t i=0; i<KEYS; i++ )
+		CHECK(arena_entry_ok(map_key_get(map, key_of("a key long enough to leave the entry #", i)), i));
+	
+	/// values growing past the inline buffer move into the arena, through both set paths.
+	bool inserted = false;
+	MapEntry *entry = map_key_entry(map, "grow", &inserted);
+	const cell_t small[2] = { 1, 2 };
+	CHECK(map_set_array(map, entry, ArrayEntry, ( const uint8_t* )small, sizeof(cell_t), 2));
+	CHECK(entry->data.a.cap==0);
+	cell_t big[16];
+	for( cell_t k=0; k<16; k++ )
+		big[k] = -k;
+	CHECK(map_set_array(map, entry, ArrayEntry, ( const uint8_t* )big, sizeof(cell_t), 16));
+	CHECK(entry->data.a.cap > 0 && memcmp(map_value_data(&entry->data.a), big, sizeof big)==0);
+	CHECK(map_key_set(map, "grow", StrEntry, entry_data_from_array(( uint8_t* )"a string too long to stay inline", sizeof(char), 32, true)));
+	entry = map_key_get(map, "grow");
+	CHECK(entry != nullptr && entry->tag==StrEntry && entry->data.a.cap > 0);
+	CHECK(entry != nullptr && strcmp(( const char* )map_value_data(&entry->data.a), "a string too long to stay inline")==0);
+	CHECK(map_key_rm(map, "grow"));
+	
+	/// removals leave holes, compaction keeps the survivors in order and intact.
+	for( cell_t i=0; i<KEYS; i += 2 )
+		CHECK(map_key_rm(map, key_of("a key long enough to leave the entry #", i)));
+	map_compact(map);
+	CHECK(map->len==KEYS / 2 && map_span(map)==KEYS / 2);
+	for( cell_t i=1; i<KEYS; i += 2 ) {
+		CHECK(arena_entry_ok(map_idx_get(map, ( size_t )i / 2), i));
+		CHECK(map_key_get(map, key_of("a key long enough to leave the entry #", i - 1))==nullptr);
+	}
+	
+	/// clearing keeps the chunks, refilling the same amount needs no new ones.
+	const size_t chunks = arena_chunks(map);
+	map_clear(map);
+	CHECK(map->len==0 && map_span(map)==0);
+	CHECK(map_key_get(map, key_of("a key long enough to leave the entry #", 1))==nullptr);
+	CHECK(arena_chunks(map)==chunks);
+	fill_arena(map, KEYS);
+	CHECK(arena_chunks(map)==chunks);
+	for( cell_t i=0; i<KEYS; i++ )
+		CHECK(arena_entry_ok(map_idx_get(map, ( size_t )i), i));
+	map_free(&map);
+}
+
+/// cell keys are compared as integers, never as their text, and share a map with string keys.
+void test_cell_keys() {
+	CMap *map = new_map();
+	const cell_t keys[] = { 0, 1, -1, 42, 0x7fffffff, ( cell_t )0x80000000, 1000000 };
+	for( const cell_t key : keys ) {
+		bool inserted = false;
+		MapEntry *entry = map_cell_entry(map, key, &inserted);
+		CHECK(entry != nullptr && inserted && entry->key.type==CellKey);
+		CHECK(map_assign(map, entry, CellEntry, entry_data_from_int(key ^ 0x55)));
+	}
+	CHECK(map->len==sizeof keys / sizeof keys[0]);
+	
+	/// finding one again creates nothing, and "42" the string is a different key than 42 the cell.
+	bool inserted = true;
+	CHECK(map_cell_entry(map, 42, &inserted)==map_cell_get(map, 42) && !inserted);
+	CHECK(!map_has_key(map, "42"));
+	CHECK(map_insert(map, "42", CellEntry, entry_data_from_int(-42)));
+	CHECK(cell_of(map_key_get(map, "42"))==-42);
+	CHECK(cell_of(map_cell_get(map, 42))==(42 ^ 0x55));
+	
+	for( const cell_t key : keys ) {
+		CHECK(map_has_cell(map, key));
+		CHECK(cell_of(map_cell_get(map, key))==(key ^ 0x55));
+	}
+	CHECK(map_cell_get(map, 2)==nullptr);
+	
+	CHECK(map_cell_rm(map, -1));
+	CHECK(!map_cell_rm(map, -1));
+	CHECK(map_cell_get(map, -1)==nullptr);
+	CHECK(cell_of(map_cell_get(map, 1))==(1 ^ 0x55));
+	CHECK(cell_of(map_key_get(map, "42"))==-42);
+	map_free(&map);
+}
+
+/// 64-bit keys keep their high half, a SteamID64 never collides with a cell key sharing its low bits.
+void test_wide_keys() {
+	CMap *map = new_map();
+	const uint64_t base = 76561197960265728ull;
+	for( cell_t i=0; i<100; i++ ) {
+		bool inserted = false;
+		MapEntry *entry = map_wide_entry(map, base + ( uint64_t )i, &inserted);
+		CHECK(entry != nullptr && inserted);
+		CHECK(map_assign(map, entry, CellEntry, entry_data_from_int(i)));
+	}
+	bool inserted = false;
+	MapEntry *entry = map_cell_entry(map, ( cell_t )( uint32_t )base, &inserted);
+	CHECK(entry != nullptr && inserted);
+	CHECK(map_assign(map, entry, CellEntry, entry_data_from_int(-1)));
+	CHECK(map_wide_entry(map, base + 1ull, &inserted)==map_wide_get(map, base + 1ull) && !inserted);
+	CHECK(map_wide_get(map, base + (1ull << 32))==nullptr);
+	CHECK(!map_has_wide(map, ( uint32_t )base));
+	
+	CHECK(map->len==101);
+	for( cell_t i=0; i<100; i++ )
+		CHECK(cell_of(map_wide_get(map, base + ( uint64_t )i))==i);
+	CHECK(cell_of(map_cell_get(map, ( cell_t )( uint32_t )base))==-1);
+	
+	CHECK(map_wide_rm(map, base));
+	CHECK(!map_has_wide(map, base));
+	CHECK(cell_of(map_cell_get(map, ( cell_t )( uint32_t )base))==-1);
+	CHECK(cell_of(map_wide_get(map, base + 99ull))==99);
+	map_free(&map);
+}
+
+/// maps sharing a key pool store each string key once and free it with its last entry.
+void test_interned_keys() {
+	MapKeyPool pool;
+	map_key_pool_init(&pool);
+	CMap *a = new_map(8, MapInternKeys, &pool);
+	CMap *b = new_map(8, MapInternKeys, &pool);
+	CMap *plain = new_map();
+	fill(a, "shared", 50);
+	fill(b, "shared", 50);
+	fill(plain, "shared", 50);
+	CHECK(a->len==50 && b->len==50);
+	CHECK(pool.len==50);
+	
+	for( cell_t i=0; i<50; i++ ) {
+		const MapEntry *in_a = map_key_get(a, key_of("shared", i));
+		const MapEntry *in_b = map_key_get(b, key_of("shared", i));
+		CHECK(cell_of(in_a)==i && cell_of(in_b)==i);
+		CHECK(in_a != nullptr && in_b != nullptr && in_a->key.type==InternKey && in_a->key.s.num==in_b->key.s.num);
+		CHECK(in_a != nullptr && strcmp(map_key_cstr(&in_a->key), key_of("shared", i))==0);
+		CHECK(in_a != nullptr && map_interned(in_a->key.s.num)->refs==2);
+		/// a map outside the pool still finds the same text.
+		CHECK(cell_of(map_key_get(plain, key_of("shared", i)))==i);
+	}
+	
+	/// a key leaves the pool once no map uses it anymore.
+	const MapKeyView view = map_str_key("shared7");
+	CHECK(map_key_rm(a, "shared7"));
+	CHECK(map_key_pool_get(&pool, &view) != nullptr && map_key_pool_get(&pool, &view)->refs==1);
+	CHECK(map_key_rm(b, "shared7"));
+	CHECK(map_key_pool_get(&pool, &view)==nullptr);
+	CHECK(pool.len==49);
+	
+	CHECK(map_insert(a, "shared7", CellEntry, entry_data_from_int(77)));
+	CHECK(cell_of(map_key_get(a, "shared7"))==77 && map_key_get(b, "shared7")==nullptr);
+	map_free(&a);
+	CHECK(pool.len==49);
+	map_free(&b);
+	CHECK(pool.len==0);
+	map_free(&plain);
+	map_key_pool_clear(&pool);
+}
+
+/// a token only resolves to what its pool made, and finds nothing once its key is removed from a map.
+void test_stale_tokens() {
+	MapKeyPool pool;
+	map_key_pool_init(&pool);
+	CMap *map = new_map(8, MapInternKeys, &pool);
+	const MapKeyView view = map_str_key("token");
+	const uint32_t token = map_key_pool_token(&pool, &view);
+	CHECK(token != 0);
+	CHECK(map_key_pool_token(&pool, &view)==token);
+	CHECK(map_key_pool_from_token(&pool, 0)==nullptr);
+	CHECK(map_key_pool_from_token(&pool, token + 1)==nullptr);
+	
+	const MapInterned *ik = map_key_pool_from_token(&pool, token);
+	CHECK(ik != nullptr);
+	const MapKeyView key = map_token_key(map, ik);
+	bool inserted = false;
+	MapEntry *entry = map_view_entry(map, &key, &inserted);
+	CHECK(entry != nullptr && inserted);
+	CHECK(map_assign(map, entry, CellEntry, entry_data_from_int(7)));
+	CHECK(cell_of(map_view_get(map, &key))==7);
+	CHECK(cell_of(map_key_get(map, "token"))==7);
+	
+	CHECK(map_view_rm(map, &key));
+	CHECK(map_view_get(map, &key)==nullptr);
+	CHECK(!map_view_rm(map, &key));
+	/// the token outlives the entry, it keeps naming the same key.
+	CHECK(map_key_pool_from_token(&pool, token)==ik);
+	CHECK(map_insert(map, "token", CellEntry, entry_data_from_int(8)));
+	CHECK(cell_of(map_view_get(map, &key))==8);
+	
+	map_free(&map);
+	map_key_pool_clear(&pool);
+	CHECK(map_key_pool_from_token(&pool, token)==nullptr);
+}
+
+/// a removed entry's id stops matching, even once its id slot is handed out again.
+void test_stale_ids() {
+	CMap *map = new_map();
+	fill(map, "id", 3);
+	MapEntry *entry = map_key_get(map, "id1");
+	const uint32_t first = map_entry_id(map, entry);
+	CHECK(first != 0);
+	CHECK(map_entry_id(map, entry)==first);
+	CHECK(map_id_get(map, first)==entry);
+	CHECK(map_id_get(map, 0)==nullptr);
+	CHECK(map_id_get(map, first + 1)==nullptr);
+	
+	CHECK(map_id_rm(map, first));
+	CHECK(map_id_get(map, first)==nullptr);
+	CHECK(!map_id_rm(map, first));
+	CHECK(map_key_get(map, "id1")==nullptr && map->len==2);
+	
+	/// the next id reuses the slot under a new generation.
+	entry = map_key_get(map, "id2");
+	const uint32_t second = map_entry_id(map, entry);
+	CHECK(second != 0 && second != first);
+	CHECK((second & ((1u << MAP_ID_BITS) - 1))==(first & ((1u << MAP_ID_BITS) - 1)));
+	CHECK(map_id_get(map, first)==nullptr);
+	CHECK(map_id_get(map, second)==entry);
+	
+	/// clearing retires every id.
+	map_clear(map);
+	CHECK(map_id_get(map, second)==nullptr);
+	map_free(&map);
+}
+
+/// freed id slots are reused oldest first, and a slot is retired before its generation could wrap.
+void test_id_churn() {
+	CMap *map = new_map();
+	fill(map, "churn", 4);
+	for( cell_t i=0; i<4; i++ )
+		CHECK(map_entry_id(map, map_key_get(map, key_of("churn", i)))==( uint32_t )i + 1);
+	for( cell_t i=0; i<3; i++ )
+		CHECK(map_key_rm(map, key_of("churn", i)));
+	fill(map, "again", 3);
+	for( cell_t i=0; i<3; i++ ) {
+		const uint32_t id = map_entry_id(map, map_key_get(map, key_of("again", i)));
+		CHECK((id & ((1u << MAP_ID_BITS) - 1))==( uint32_t )i + 1);
+	}
+	
+	/// one key churning through a single free slot runs it out of generations and moves on to a fresh slot.
+	std::vector< uint32_t > seen;
+	for( uint32_t round=0; round < 3u << MAP_ID_GEN_BITS; round++ ) {
+		CHECK(map_insert(map, "hot", CellEntry, entry_data_from_int(1)));
+		const uint32_t id = map_entry_id(map, map_key_get(map, "hot"));
+		CHECK(id != 0 && id <= INT32_MAX);
+		seen.push_back(id);
+		CHECK(map_id_rm(map, id));
+		CHECK(map_id_get(map, id)==nullptr);
+	}
+	std::sort(seen.begin(), seen.end());
+	CHECK(std::adjacent_find(seen.begin(), seen.end())==seen.end());
+	CHECK(map->ids.len==7);
+	for( const uint32_t id : seen )
+		CHECK(map_id_get(map, id)==nullptr);
+	map_free(&map);
+}
+
+/// after `map_prepare_insert` a whole batch goes in without rehashing or regrowing anything.
+void test_prepare_insert() {
+	enum { BATCH = 5000 };
+	CMap *map = new_map(8, MapIncrementalRehash);
+	const cell_t n = fill_until_draining(map, "pre");
+	CHECK(map_prepare_insert(map, BATCH));
+	CHECK(map->old_slots==nullptr);
+	
+	const MapSlot *slots = map->slots;
+	const size_t cap = map->cap, vec_cap = map->vec.cap, entries = map->pool.total;
+	fill(map, "batch", BATCH);
+	CHECK(map->slots==slots && map->cap==cap && map->old_slots==nullptr);
+	CHECK(map->vec.cap==vec_cap && map->pool.total==entries);
+	CHECK(map->len==( size_t )n + BATCH);
+	for( cell_t i=0; i<n; i++ )
+		CHECK(cell_of(map_key_get(map, key_of("pre", i)))==i);
+	for( cell_t i=0; i<BATCH; i++ )
+		CHECK(cell_of(map_key_get(map, key_of("batch", i)))==i);
+	map_free(&map);
+}
+
+/// element and slice access reads and writes the stored payload in place and never runs past its end.
+void test_value_slices() {
+	CMap *map = new_map();
+	cell_t cells[16];
+	for( cell_t i=0; i<16; i++ )
+		cells[i] = i * 10;
+	
+	bool inserted = false;
+	MapEntry *entry = map_key_entry(map, "slice", &inserted);
+	CHECK(map_set_array(map, entry, ArrayEntry, ( const uint8_t* )cells, sizeof(cell_t), 16));
+	MapValue *v = &entry->data.a;
+	const uint8_t *buf = map_value_data(v);
+	
+	cell_t out[8] = {0};
+	CHECK(map_value_read(v, sizeof(cell_t), 3, out, 4)==4);
+	CHECK(out[0]==30 && out[3]==60);
+	CHECK(map_value_read(v, sizeof(cell_t), 14, out, 8)==2);
+	CHECK(out[0]==140 && out[1]==150 && out[2]==50);
+	CHECK(map_value_read(v, sizeof(cell_t), 16, out, 1)==0);
+	
+	const cell_t in[3] = { -1, -2, -3 };
+	CHECK(map_value_write(v, sizeof(cell_t), 5, in, 3)==3);
+	CHECK(map_value_write(v, sizeof(cell_t), 15, in, 3)==1);
+	CHECK(map_value_write(v, sizeof(cell_t), 16, in, 1)==0);
+	CHECK(v->len==16 && map_value_data(v)==buf);
+	const cell_t *now = ( const cell_t* )map_value_data(v);
+	CHECK(now[4]==40 && now[5]==-1 && now[7]==-3 && now[8]==80 && now[15]==-1);
+	
+	/// inline strings work the same, writes stop before the terminator.
+	entry = map_key_entry(map, "str", &inserted);
+	CHECK(map_set_array(map, entry, StrEntry, ( const uint8_t* )"hello", sizeof(char), 0));
+	v = &entry->data.a;
+	CHECK(v->cap==0);
+	char text[8] = {0};
+	CHECK(map_value_read(v, sizeof(char), 1, text, 7)==4);
+	CHECK(strcmp(text, "ello")==0);
+	CHECK(map_value_write(v, sizeof(char), 3, "p!!", 3)==2);
+	CHECK(strcmp(( const char* )map_value_data(v), "help!")==0);
+	map_free(&map);
+}
+
+/// the Add/Increment/Min/Max natives find or create an entry with one `map_*_entry` probe and update `data.i` in place.
+/// a new entry has to come back as `InvalidEntry` and an existing one as itself, whichever table it's in.
+void test_update_in_place() {
+	enum { KEYS = 1000, ROUNDS = 4 };
+	CMap *map = new_map(8, MapIncrementalRehash);
+	size_t mid_drain = 0;
+	for( cell_t round=0; round<ROUNDS; round++ ) {
+		for( cell_t i=0; i<KEYS; i++ ) {
+			bool inserted = false;
+			mid_drain += map->old_slots != nullptr;
+			MapEntry *entry = map_cell_entry(map, i, &inserted);
+			CHECK(entry != nullptr && inserted==(round==0));
+			if( entry==nullptr ) {
+				continue;
+			} else if( inserted ) {
+				CHECK(entry->tag==InvalidEntry);
+				CHECK(map_assign(map, entry, CellEntry, entry_data_from_int(i)));
+			} else {
+				CHECK(entry->tag==CellEntry);
+				entry->data.i += KEYS;
+			}
+		}
+	}
+	CHECK(mid_drain > 0);
+	CHECK(map->len==KEYS);
+	for( cell_t i=0; i<KEYS; i++ )
+		CHECK(cell_of(map_cell_get(map, i))==i + (ROUNDS - 1) * KEYS);
+	map_free(&map);
+}
+
+/// appends grow the buffer geometrically from inline to heap, pops keep it for the next push.
+void test_append_pop() {
+	CMap *map = new_map();
+	bool inserted = false;
+	MapEntry *entry = map_key_entry(map, "list", &inserted);
+	CHECK(entry != nullptr && inserted);
+	
+	size_t grows = 0, cap = 0;
+	for( cell_t i=0; i<1000; i++ ) {
+		CHECK(map_append_array(map, entry, ArrayEntry, ( const uint8_t* )&i, sizeof i, 1));
+		if( entry->data.a.cap != cap ) {
+			cap = entry->data.a.cap;
+			grows++;
+		}
+	}
+	CHECK(entry->tag==ArrayEntry && entry->data.a.len==1000);
+	CHECK(grows < 10);
+	const cell_t *cells = ( const cell_t* )map_value_data(&entry->data.a);
+	for( cell_t i=0; i<1000; i++ )
+		CHECK(cells[i]==i);
+	
+	cell_t last = 0;
+	CHECK(map_value_pop(&entry->data.a, sizeof last, &last) && last==999);
+	CHECK(map_value_pop(&entry->data.a, sizeof last, &last) && last==998);
+	CHECK(entry->data.a.len==998 && entry->data.a.cap==cap);
+	const cell_t again = 7;
+	CHECK(map_append_array(map, entry, ArrayEntry, ( const uint8_t* )&again, sizeof again, 1));
+	CHECK(entry->data.a.len==999 && entry->data.a.cap==cap && (( const cell_t* )map_value_data(&entry->data.a))[998]==7);
+	
+	/// a string entry refuses array appends, appended text stays terminated.
+	CHECK(!map_append_array(map, entry, StrEntry, ( const uint8_t* )"x", sizeof(char), 1));
+	entry = map_key_entry(map, "text", &inserted);
+	CHECK(map_append_array(map, entry, StrEntry, ( const uint8_t* )"short", sizeof(char), 5));
+	CHECK(entry->data.a.cap==0);
+	for( int i=0; i<10; i++ )
+		CHECK(map_append_array(map, entry, StrEntry, ( const uint8_t* )" and longer", sizeof(char), 11));
+	CHECK(entry->data.a.len==115 && entry->data.a.cap > 115);
+	CHECK(strlen(( const char* )map_value_data(&entry->data.a))==115);
+	CHECK(strncmp(( const char* )map_value_data(&entry->data.a), "short and longer and", 20)==0);
+	
+	char c = 0;
+	size_t pops = 0;
+	while( map_value_pop(&entry->data.a, sizeof c, &c) )
+		pops++;
+	CHECK(pops==115 && c=='s' && entry->data.a.len==0);
+	map_free(&map);
+}
+
+static bool same_entry(const MapEntry *a, const MapEntry *b) {
+	if( a==nullptr || b==nullptr )
+		return a==b;
+	else if( a==b || a->tag != b->tag || a->key.type != b->key.type || strcmp(map_key_cstr(&a->key), map_key_cstr(&b->key)) != 0 )
+		return false;
+	else if( a->tag==CellEntry )
+		return a->data.i==b->data.i;
+	return a->data.a.len==b->data.a.len && map_value_data(&a->data.a) != map_value_data(&b->data.a)
+		&& memcmp(map_value_data(&a->data.a), map_value_data(&b->data.a), a->data.a.len)==0;
+}
+
+/// a clone matches its source index for index, holes and mid-rehash entries included, and shares nothing with it.
+static void check_clone(const uint32_t flags) {
+	CMap *src = new_map(8, flags | MapStableIndices | MapIncrementalRehash);
+	for( cell_t i=0; i<100; i++ ) {
+		const char *key = key_of("string value number ", i);
+		CHECK(map_insert(src, key, StrEntry, entry_data_from_array(( uint8_t* )key, sizeof(char), strlen(key), true)));
+	}
+	const cell_t n = fill_until_draining(src, "c");
+	CHECK(map_key_rm(src, "c1"));
+	CHECK(map_key_rm(src, "c4"));
+	CHECK(src->old_slots != nullptr);
+	
+	CMap *copy = map_clone(src);
+	CHECK(copy != nullptr);
+	if( copy==nullptr ) {
+		map_free(&src);
+		return;
+	}
+	CHECK(copy->old_slots==nullptr && copy->flags==src->flags);
+	CHECK(copy->len==src->len && map_span(copy)==map_span(src));
+	for( size_t i=0; i<map_span(src); i++ )
+		CHECK(same_entry(map_idx_get(src, i), map_idx_get(copy, i)));
+	for( cell_t i=0; i<n; i++ ) {
+		const MapEntry *entry = map_key_get(src, key_of("c", i));
+		CHECK(same_entry(entry, map_key_get(copy, key_of("c", i))));
+	}
+	
+	/// changes on either side stay there.
+	CHECK(map_key_rm(src, "c0"));
+	CHECK(map_key_set(src, "c2", CellEntry, entry_data_from_int(-2)));
+	CHECK(map_insert(copy, "only-copy", CellEntry, entry_data_from_int(1)));
+	CHECK(map_key_get(copy, "c0") != nullptr);
+	CHECK(cell_of(map_key_get(copy, "c2"))==2);
+	CHECK(map_key_get(src, "only-copy")==nullptr);
+	CHECK(copy->len==src->len + 2);
+	
+	map_free(&src);
+	CHECK(cell_of(map_key_get(copy, "c5"))==5);
+	CHECK(map_key_get(copy, "c1")==nullptr);
+	const MapEntry *str = map_key_get(copy, "string value number 3");
+	CHECK(str != nullptr && strcmp(( const char* )map_value_data(&str->data.a), "string value number 3")==0);
+	map_free(&copy);
+}
+
+void test_clone() {
+	check_clone(MapDefault);
+	check_clone(MapArenaAlloc);
+}
+
 int main() {
 	CMap *map = new_map();
 	map_insert(map, "a", CellEntry, (union MapEntryData){1});
@@ -51,6 +748,11 @@ int main() {
 	map_insert(map, "i", CellEntry, (union MapEntryData){555});
 	map_insert(map, "j", CellEntry, (union MapEntryData){666});
 	map_insert(map, "k", CellEntry, (union MapEntryData){777});
+	
+	bool inserted = false;
+	union MapEntryData answer;
+	answer.i = 4242;
+	map_assign(map, map_cell_entry(map, 42, &inserted), CellEntry, answer);
 	print_map(map);
 
 	print_entry(map_key_get(map, "a"));
@@ -83,4 +785,23 @@ int main() {
 	print_map(map);
 
 	map_free(&map);
+	
+	test_stable_indices();
+	test_incremental_rehash();
+	test_inline_values();
+	test_pool_repack();
+	test_arena();
+	test_cell_keys();
+	test_wide_keys();
+	test_interned_keys();
+	test_stale_tokens();
+	test_stale_ids();
+	test_id_churn();
+	test_prepare_insert();
+	test_value_slices();
+	test_update_in_place();
+	test_append_pop();
+	test_clone();
+	std::cout << (g_failed==0? "all checks passed\n" : "some checks failed\n");
+	return g_failed != 0;
 }